@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+// interface for other SKSE plugins, resolved at runtime so CustomConsole stays an optional dependency
+// include after <Windows.h>, which every SKSE plugin already pulls in through its PCH
+namespace CustomConsole
+{
+	// a_result is only valid during the call, a_success is false for vanilla or unknown commands and bind errors
+	// called on CustomConsole's worker thread or the main thread, never on the submitting thread
+	using ResultCallback = void (*)(const char* a_result, bool a_success, void* a_userData);
+
+	// queues a_line from any thread without blocking, returns false if the queue is full
+	// a_line may be a custom command, a macro or a c3 builtin, vanilla console commands are rejected through the callback
+	// a_target is the FormID of the selected reference, or 0 for none
+	using ExecuteFunc = bool (*)(const char* a_line, std::uint32_t a_target, ResultCallback a_callback, void* a_userData);
+
+	inline ExecuteFunc GetExecute()
+	{
+		static const auto func = []() -> ExecuteFunc {
+			const auto module = ::GetModuleHandleW(L"CustomConsole");
+			return module ? reinterpret_cast<ExecuteFunc>(::GetProcAddress(module, "CustomConsole_Execute")) : nullptr;
+		}();
+		return func;
+	}
+
+	// false if CustomConsole is not installed or its queue is full
+	inline bool Execute(const char* a_line, std::uint32_t a_target = 0, ResultCallback a_callback = nullptr, void* a_userData = nullptr)
+	{
+		const auto func = GetExecute();
+		return func && func(a_line, a_target, a_callback, a_userData);
+	}
+}
@@ -0,0 +1,20 @@
+#include "CustomConsole.h"
+#include "Commands.h"
+
+using namespace C3;
+
+extern "C" DLLEXPORT bool CustomConsole_Execute(const char* a_line, std::uint32_t a_target, CustomConsole::ResultCallback a_callback, void* a_userData)
+{
+	if (!a_line)
+		return false;
+
+	Reply reply;
+	if (a_callback) {
+		reply = [a_callback, a_userData](std::string_view a_result, bool a_success) {
+			const std::string result{ a_result };
+			a_callback(result.c_str(), a_success, a_userData);
+		};
+	}
+
+	return Commands::Enqueue(a_line, a_target, std::move(reply));
+}
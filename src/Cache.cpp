@@ -0,0 +1,64 @@
+#include "Cache.h"
+
+using namespace C3;
+
+std::string Cache::MakeKey(const Command& a_cmd, const SubCommand& a_sub, const std::vector<std::string>& a_values, std::uint32_t a_formID)
+{
+	std::string key{ std::format("{}\x1f{}\x1f{:08X}", a_cmd.name, a_sub.name, a_formID) };
+	for (const auto& val : a_values) {
+		key += '\x1f';
+		key += val;
+	}
+	return key;
+}
+
+std::optional<std::string> Cache::Get(const std::string& a_key)
+{
+	std::unique_lock lock{ _lock };
+
+	auto it = _lookup.find(a_key);
+	if (it == _lookup.end())
+		return std::nullopt;
+
+	auto entry = it->second;
+	if (entry->expiry && *entry->expiry <= Clock::now()) {
+		_lookup.erase(it);
+		_entries.erase(entry);
+		return std::nullopt;
+	}
+
+	_entries.splice(_entries.begin(), _entries, entry);
+	return entry->result;
+}
+
+void Cache::Put(const std::string& a_key, const std::string& a_result, float a_ttl)
+{
+	std::unique_lock lock{ _lock };
+
+	// the map's keys view into the entries, so the map goes first
+	if (auto it = _lookup.find(a_key); it != _lookup.end()) {
+		const auto entry = it->second;
+		_lookup.erase(it);
+		_entries.erase(entry);
+	}
+
+	if (_entries.size() >= Capacity) {
+		_lookup.erase(_entries.back().key);
+		_entries.pop_back();
+	}
+
+	auto& entry = _entries.emplace_front(Entry{ a_key, a_result, std::nullopt });
+	if (a_ttl > 0.0f)
+		entry.expiry = Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(a_ttl));
+
+	_lookup[entry.key] = _entries.begin();
+}
+
+void Cache::Clear()
+{
+	std::unique_lock lock{ _lock };
+
+	logger::info("clearing {} cached results", _entries.size());
+	_lookup.clear();
+	_entries.clear();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Command.h"
+
+namespace C3
+{
+	// bounded LRU of results for pure subcommands, keyed by the bound arguments and selected ref
+	class Cache
+	{
+	public:
+		static std::string MakeKey(const Command& a_cmd, const SubCommand& a_sub, const std::vector<std::string>& a_values, std::uint32_t a_formID);
+		static std::optional<std::string> Get(const std::string& a_key);
+		static void Put(const std::string& a_key, const std::string& a_result, float a_ttl);
+		static void Clear();
+	private:
+		using Clock = std::chrono::steady_clock;
+
+		struct Entry
+		{
+			std::string key;
+			std::string result;
+			std::optional<Clock::time_point> expiry;
+		};
+
+		static constexpr std::size_t Capacity = 1024;
+
+		static inline std::mutex _lock;
+		static inline std::list<Entry> _entries;
+		static inline std::unordered_map<std::string_view, std::list<Entry>::iterator> _lookup;
+	};
+}
@@ -1,10 +1,16 @@
 #pragma once
 
+#include "StringPool.h"
+#include "Validator.h"
+
 namespace C3
 {
+	struct DispatchTarget;
+
+	// all string members are views into the StringPool owned by the registry
 	struct Arg
 	{
-		enum Type
+		enum Type : std::uint8_t
 		{
 			Int,
 			Bool,
@@ -13,9 +19,16 @@ namespace C3
 			Object,
 		};
 
-		inline std::string Help()
+		inline std::string Help() const
 		{
-			std::string msg{ "   " + name + " (" + rawType + ")" };
+			std::string msg{ "   " };
+			msg += name;
+			msg += " (";
+			msg += rawType;
+			if (array) {
+				msg += "[]";
+			}
+			msg += ")";
 			if (selected) {
 				msg += " (selectable)";
 			}
@@ -23,33 +36,40 @@ namespace C3
 				msg += " (required)";
 			}
 
-			if (!help.empty())
-				msg += ": " + help;
+			if (!help.empty()) {
+				msg += ": ";
+				msg += help;
+			}
 			msg += "\n";
 			return msg;
 		}
 
-		std::string name;
-		std::string help;
-		std::string defaultVal;
-		std::string alias;
-		Type type;
-		std::string rawType;
-		bool positional = false;
-		bool selected = false;
-		bool flag = false;
-		bool required = false;
+		std::string_view name;
+		std::string_view help;
+		std::string_view defaultVal;
+		std::string_view alias;
+		std::string_view rawType;
+		const Validator* validator = nullptr;
+		Type type = Type::Object;
+		bool positional : 1 = false;
+		bool selected : 1 = false;
+		bool flag : 1 = false;
+		bool required : 1 = false;
+		bool array : 1 = false;
 	};
 
 	struct SubCommand
 	{
-		std::string Help()
+		std::string Help() const
 		{
 			std::string spacing(3, ' ');
-			std::string msg{ spacing + name };
-			
-			if (!help.empty())
-				msg += ": " + help;
+			std::string msg{ spacing };
+			msg += name;
+
+			if (!help.empty()) {
+				msg += ": ";
+				msg += help;
+			}
 			msg += "\n";
 
 			for (auto& arg : args) {
@@ -60,8 +80,16 @@ namespace C3
 			return msg;
 		}
 
-		inline Arg* GetFlag(std::string a_name) { return flags.count(a_name) ? &args[flags[a_name]] : nullptr; }
-		inline Arg* GetSelected() 
+		inline const Arg* GetFlag(std::string_view a_name) const
+		{
+			for (auto& arg : args) {
+				if (!arg.positional && (arg.name == a_name || (!arg.alias.empty() && arg.alias == a_name)))
+					return &arg;
+			}
+
+			return nullptr;
+		}
+		inline const Arg* GetSelected() const
 		{
 			for (auto& arg : args) {
 				if (arg.selected)
@@ -70,110 +98,72 @@ namespace C3
 
 			return nullptr;
 		}
-		std::string name;
-		std::string func;
-		std::string help;
-		std::string alias;
+		inline std::vector<std::string_view> GetFlagNames() const
+		{
+			std::vector<std::string_view> names;
+			for (auto& arg : args) {
+				if (!arg.positional) {
+					names.push_back(arg.name);
+					names.push_back(arg.alias);
+				}
+			}
+			return names;
+		}
+		inline std::size_t IndexOf(const Arg* a_arg) const { return static_cast<std::size_t>(a_arg - args.data()); }
+		inline bool IsCached() const { return pure || ttl > 0.0f; }
+
+		std::string_view name;
+		std::string_view func;
+		std::string_view help;
+		std::string_view alias;
 		std::vector<Arg> args;
-		std::unordered_map<std::string, int> flags;
-		std::unordered_map<std::string, int> all;
-		bool close;
+		mutable const DispatchTarget* target = nullptr;  // published by the Dispatcher once resolved
+		float ttl = 0.0f;
+		bool close = false;
+		bool pure = false;
 	};
 
 	struct Command
 	{
-		inline std::string Help() 
+		inline std::string Help() const
 		{
-			std::string msg{ name + " (" + alias + ") : " + help + "\n" };
+			std::string msg;
+			msg += name;
+			msg += " (";
+			msg += alias;
+			msg += ") : ";
+			msg += help;
+			msg += "\n";
 			for (auto& sub : subs) {
 				msg += sub.Help();
 			}
 			return msg;
 		}
 
-		SubCommand* GetSub(std::string a_name) { return map.count(a_name) ? &map[a_name] : nullptr; } 
-
-		std::string name;
-		std::string help;
-		std::string alias;
-		std::string script;
-		std::vector<SubCommand> subs;
-		std::unordered_map<std::string, SubCommand> map;
-	};
-}
-
-namespace YAML
-{
-	template <>
-	struct convert<C3::Arg>
-	{
-		static bool decode(const Node& node, C3::Arg& rhs)
-		{
-			rhs.name = node["name"].as<std::string>("");
-			rhs.help = node["help"].as<std::string>("");
-			rhs.defaultVal = node["default"].as<std::string>("");
-			rhs.alias = node["alias"].as<std::string>("");
-			rhs.selected = node["selected"].as<std::string>("false") == "true";
-			rhs.flag = node["flag"].as<std::string>("false") == "true";
-			rhs.required = node["required"].as<std::string>("false") == "true";
-
-			rhs.positional = !rhs.name.starts_with("-");
-
-			rhs.rawType = node["type"].as<std::string>("");
-			rhs.type = magic_enum::enum_cast<C3::Arg::Type>(rhs.rawType, magic_enum::case_insensitive).value_or(C3::Arg::Type::Object);
-
-			return !rhs.name.empty();
-		}
-	};
-
-	template <>
-	struct convert<C3::SubCommand>
-	{
-		static bool decode(const Node& node, C3::SubCommand& rhs)
+		inline const SubCommand* GetSub(std::string_view a_name) const
 		{
-			rhs.name = node["name"].as<std::string>("");
-			rhs.help = node["help"].as<std::string>("");
-			rhs.alias = node["alias"].as<std::string>("");
-			rhs.func = node["func"].as<std::string>("");
-			rhs.close = node["close"].as<std::string>("") == "true";
-			
-			// TODO: arg name/alias collision checks
-			rhs.args = node["args"].as<std::vector<C3::Arg>>(std::vector<C3::Arg>{});
-			for (int i = 0; i < rhs.args.size(); i++) {
-				auto& arg = rhs.args[i];
-
-				if (!arg.positional) {
-					rhs.flags[arg.name] = i;
-					if (!rhs.alias.empty())
-						rhs.flags[arg.alias] = i;
-				}
-
-				rhs.all[arg.name] = i;
-
+			for (auto& sub : subs) {
+				if (sub.name == a_name || (!sub.alias.empty() && sub.alias == a_name))
+					return &sub;
 			}
 
-			return !rhs.name.empty() && !rhs.func.empty();
+			return nullptr;
 		}
-	};
 
-	template <>
-	struct convert<C3::Command>
-	{
-		static bool decode(const Node& node, C3::Command& rhs)
+		inline std::vector<std::string_view> GetSubNames() const
 		{
-			rhs.name = node["name"].as<std::string>("");
-			rhs.help = node["help"].as<std::string>("");
-			rhs.alias = node["alias"].as<std::string>("");
-			rhs.script = node["script"].as<std::string>("");
-
-			// TODO: sub name/alias collision checks
-			rhs.subs = node["subs"].as<std::vector<C3::SubCommand>>(std::vector<C3::SubCommand>{});
-			for (auto& sub : rhs.subs) {
-				rhs.map[sub.name] = sub;
-				rhs.map[sub.alias] = sub;
+			std::vector<std::string_view> names;
+			for (auto& sub : subs) {
+				names.push_back(sub.name);
+				names.push_back(sub.alias);
 			}
-
-			return !rhs.name.empty() && !rhs.script.empty();
+			return names;
 		}
+
+		std::string_view name;
+		std::string_view help;
+		std::string_view alias;
+		std::string_view script;
+		std::vector<SubCommand> subs;
 	};
-}
\ No newline at end of file
+}
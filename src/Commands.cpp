@@ -1,5 +1,11 @@
 #include "Commands.h"
+#include "Cache.h"
+#include "Dispatcher.h"
+#include "Parser.h"
+#include "Recorder.h"
 #include "Util.h"
+#include "Worker.h"
+#include "Writer.h"
 
 using namespace C3;
 namespace fs = std::filesystem;
@@ -11,219 +17,1098 @@ void Commands::Load()
 
 	logger::info("loading commands");
 
+	std::vector<std::pair<std::string, std::string>> sources;
+
 	for (const auto& entry : fs::directory_iterator(dir)) {
 		if (entry.is_directory())
 			continue;
 
 		auto path = entry.path();
-		
-		if (path.extension() == ".yaml" || path.extension() == ".yaml") {
-			try {
-				YAML::Node node = YAML::LoadFile(path.string());
-				auto command = node.as<Command>();
-				logger::info("registering command {} {} w/ {} subcommands", command.name, command.alias, command.subs.size());
-
-				if (_commands.count(command.name)) {
-					logger::error("{} already registered as a command - skipping", command.name);
+		const auto extension = path.extension();
+
+		if (extension != ".yaml" && extension != ".yml" && extension != ".json")
+			continue;
+
+		const auto fileIndex = static_cast<std::uint32_t>(_files.size());
+		auto& file = _files.emplace_back();
+		file.path = path;
+
+		try {
+			if (extension != ".json") {
+				// only the top-level keys are read here, a lone command is decoded on first use
+				const auto start = std::chrono::steady_clock::now();
+				const auto header = Scan(path);
+				file.scan = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+				if (!header.name.empty() && !header.bundle && !header.macros) {
+					file.lazy = true;
+					Register(header.name, header.alias, fileIndex);
 					continue;
 				}
-				else
-					_commands[command.name] = command;
-				
-				if (_commands.count(command.alias))
-					logger::error("{} command alias already registered as a command - skipping", command.alias);
-				else
-					_commands[command.alias] = command;
-
-
-			} catch (std::exception& e) {
-				logger::error("failed to create command from file: {} due to {}", path.string(), e.what());
-			} catch (...) {
-				logger::error("failed to create command from file: {}", path.string());
 			}
+
+			// bundles, macro files and json are decoded in one streaming pass
+			auto result = Decoder::DecodeFile(path);
+			for (const auto& error : result.errors) {
+				logger::error("{}: {}", path.string(), error);
+			}
+
+			file.decode = result.elapsed;
+			file.events = result.events;
+			file.macros = result.macros.size();
+
+			for (auto& collision : result.collisions) {
+				_collisions.push_back(std::format("{}: {}", path.filename().string(), collision));
+			}
+
+			for (auto& command : result.commands) {
+				if (auto registered = Register(command.name, command.alias, fileIndex)) {
+					logger::info("registering command {} {} w/ {} subcommands", command.name, command.alias, command.subs.size());
+					registered->command = std::move(command);
+					registered->loaded = true;
+				}
+			}
+
+			std::move(result.macros.begin(), result.macros.end(), std::back_inserter(sources));
+		} catch (std::exception& e) {
+			logger::error("failed to create command from file: {} due to {}", path.string(), e.what());
+		} catch (...) {
+			logger::error("failed to create command from file: {}", path.string());
 		}
 	}
 
+	_commands.shrink_to_fit();
+
+	// macros are compiled once every command is known so they can reference any of them
+	CompileMacros(sources);
+
+	logger::info("registered {} commands, {} interned strings in {} bytes", _commands.size(), StringPool::GetCount(), StringPool::GetBytes());
+	logger::info("{}", Report());
 }
 
-bool Commands::Parse(const std::string& a_command, RE::TESObjectREFR* a_ref)
+void Commands::Resolve()
 {
-	std::istringstream iss(a_command);
-	std::vector<std::string> tokens;
-	std::string split;
+	std::vector<const Command*> loaded;
+	std::vector<std::string> deferred;
 
-	while (iss >> std::quoted(split)) {
-		tokens.push_back(split);
+	{
+		std::shared_lock guard{ _lock };
+		for (const auto& entry : _commands) {
+			if (entry.loaded)
+				loaded.push_back(&entry.command);
+			else if (!entry.failed)
+				deferred.emplace_back(entry.command.name);
+		}
 	}
 
-	if (auto cmd = GetCmd(tokens[0])) {
+	CheckTargets(loaded, "");
+	if (deferred.empty())
+		return;
 
-		logger::info("command {} recognized", cmd->name);
-		
-		if (tokens.size() == 1) {
-			Print(cmd->Help());
-			return true;
-		} 
+	// lazily registered files stay off the load path, the worker decodes them now and the main thread checks them
+	logger::info("decoding {} lazily loaded commands in the background", deferred.size());
+	Worker::Enqueue([deferred = std::move(deferred)]() {
+		std::vector<const Command*> decoded;
+		for (const auto& name : deferred) {
+			if (const auto cmd = GetCmd(name))
+				decoded.push_back(cmd);
+		}
 
-		if (tokens[1] == "-h" || tokens[1] == "--help") {
-			Print(cmd->Help());
-			return true;
+		SKSE::GetTaskInterface()->AddTask([decoded = std::move(decoded)]() {
+			CheckTargets(decoded, "lazily loaded ");
+		});
+	});
+}
+
+void Commands::CheckTargets(const std::vector<const Command*>& a_commands, std::string_view a_kind)
+{
+	std::size_t checked = 0;
+	std::size_t invalid = 0;
+
+	for (const auto cmd : a_commands) {
+		for (const auto& sub : cmd->subs) {
+			checked++;
+			if (!Dispatcher::Get(*cmd, sub).IsValid())
+				invalid++;
 		}
+	}
 
-		if (auto sub = cmd->GetSub(tokens[1])) {
-			logger::info("subcommand {} recognized", sub->name);
+	logger::info("checked {} {}subcommands against papyrus, {} rejected", checked, a_kind, invalid);
+}
 
-			std::unordered_map<std::string, std::string> flags;
-			std::vector<std::string> positional;
-			std::string unrecognized;
-			std::string invalid;
+Commands::Header Commands::Scan(const fs::path& a_path)
+{
+	const auto value = [](std::string_view a_str) {
+		while (!a_str.empty() && std::isspace(static_cast<unsigned char>(a_str.front())))
+			a_str.remove_prefix(1);
 
-			if (auto selected = sub->GetSelected()) {
-				if (a_ref) {
-					if (selected->positional)
-						positional.emplace_back("selected");
-					else
-						flags[selected->name] = "selected";
-				}
-			}
+		if (!a_str.empty() && (a_str.front() == '"' || a_str.front() == '\'')) {
+			const auto end = a_str.find(a_str.front(), 1);
+			return std::string{ a_str.substr(1, end == std::string_view::npos ? std::string_view::npos : end - 1) };
+		}
 
-			bool help = false;
+		if (const auto comment = a_str.find(" #"); comment != std::string_view::npos)
+			a_str = a_str.substr(0, comment);
 
-			// TODO: add support for --flag=value pattern
-			// TODO: add support for arrays
-			for (int i = 2; i < tokens.size(); i++) {
-				const auto token = tokens[i];
+		while (!a_str.empty() && std::isspace(static_cast<unsigned char>(a_str.back())))
+			a_str.remove_suffix(1);
 
-				if (token == "-h" || token == "--help") {
-					help = true;
-					break;
-				}
+		return std::string{ a_str };
+	};
 
-				if (token.starts_with("-") && !Util::IsNumeric(token)) {
-					if (auto arg = sub->GetFlag(token)) {
-						if (arg->flag) {
-							flags[arg->name] = "true";
-						} else if ((i + 1) < tokens.size() && !tokens[i + 1].starts_with("--") && (!tokens[i + 1].starts_with("-")) || Util::IsNumeric(tokens[i + 1])) {
-							flags[arg->name] = tokens[i + 1];
-							logger::info("adding {} to flags", tokens[i + 1]);
-							i++;
-						} else {
-							invalid += arg->name;
-							invalid += " ";
-						}
-					} else {
-						unrecognized += token;
-						unrecognized += " ";
-					}
-				} else {
-					logger::info("adding {} to positional", token);
-					positional.push_back(token);
-				}
-			}
+	// only the header is read, the scan stops at subs: so startup does not scale with file size
+	// bundles announce themselves up front with ---, a root list or a commands: key
+	std::ifstream file{ a_path };
+	Header header;
+	std::string line;
 
-			if (help) {
-				Print(cmd->Help());
-				return true;
+	while (std::getline(file, line)) {
+		if (line.starts_with("---")) {
+			header.bundle = true;
+			break;
+		}
+
+		if (line.empty() || std::isspace(static_cast<unsigned char>(line[0])) || line[0] == '#')
+			continue;
+
+		// a root list or flow collection can only be read by the full decoder, later dashes are compact lists under a key
+		if (line[0] == '-' || line[0] == '[' || line[0] == '{') {
+			header.bundle = true;
+			break;
+		}
+
+		const auto colon = line.find(':');
+		if (colon == std::string::npos)
+			continue;
+
+		const std::string_view key{ line.data(), colon };
+		if (key == "name") {
+			header.name = value(std::string_view{ line }.substr(colon + 1));
+		} else if (key == "alias") {
+			header.alias = value(std::string_view{ line }.substr(colon + 1));
+		} else if (key == "macro" || key == "macros") {
+			header.macros = true;
+		} else if (key == "commands") {
+			header.bundle = true;
+			break;
+		} else if (key == "subs" && !header.name.empty()) {
+			break;
+		}
+	}
+
+	return header;
+}
+
+void Commands::CompileMacros(const std::vector<std::pair<std::string, std::string>>& a_sources)
+{
+	std::unordered_map<std::string, std::vector<std::string>> bodies;
+	for (const auto& [name, body] : a_sources) {
+		if (name.empty() || name == Builtin || _lookup.contains(name) || bodies.contains(name)) {
+			logger::error("{} already registered - skipping macro", name);
+			continue;
+		}
+		bodies[name] = Parser::SplitLines(body);
+	}
+
+	// nested macros are flattened into their callers, the stack catches cycles
+	std::unordered_map<std::string, std::vector<std::vector<std::string>>> expanded;
+	std::unordered_set<std::string> failed;
+	std::vector<std::string> stack;
+
+	std::function<bool(const std::string&)> expand = [&](const std::string& a_name) {
+		if (expanded.contains(a_name))
+			return true;
+		if (failed.contains(a_name))
+			return false;
+
+		if (std::find(stack.begin(), stack.end(), a_name) != stack.end()) {
+			std::string cycle;
+			for (const auto& name : stack) {
+				cycle += name;
+				cycle += " -> ";
 			}
+			logger::error("macro cycle detected: {}{}", cycle, a_name);
+			return false;
+		}
+
+		stack.push_back(a_name);
 
-			if (!unrecognized.empty()) {
-				PrintErr(std::format("unrecognized flag arguments: {}", unrecognized));
+		std::vector<std::vector<std::string>> lines;
+		bool valid = true;
+
+		for (const auto& line : bodies.at(a_name)) {
+			auto tokens = Parser::Tokenize(line);
+			if (tokens.empty())
+				continue;
+
+			if (!bodies.contains(tokens[0])) {
+				lines.push_back(std::move(tokens));
+				continue;
 			}
 
-			if (!invalid.empty()) {
-				PrintErr(std::format("invalid flag arguments - was expecting value for: {}", invalid));
+			if (!expand(tokens[0])) {
+				valid = false;
+				break;
 			}
 
-			if (!unrecognized.empty() || !invalid.empty()) {
-				return true;
+			const std::vector<std::string> args{ tokens.begin() + 1, tokens.end() };
+			for (const auto& nested : expanded.at(tokens[0])) {
+				lines.push_back(Parser::Substitute(nested, args));
 			}
+		}
 
-			std::vector<std::string> values;
-			values.resize(sub->args.size());
-
-			std::string missing;
-
-			int pos = 0;
-			for (const auto& arg : sub->args) {
-				int index = sub->all[arg.name];
-
-				if (arg.positional && pos < positional.size()) {
-					values[index] = positional[pos];
-					logger::info("setting {} to {}", index, positional[pos]);
-					pos++;
-				} else if (!arg.positional && flags.count(arg.name)) {
-					logger::info("setting {} to {}", index, flags[arg.name]);
-					values[index] = flags[arg.name];
-				} else if (!arg.required) {
-					logger::info("setting {} to {}", index, Util::GetDefault(arg));
-					values[index] = Util::GetDefault(arg);
-					values[index] = Util::GetDefault(arg);
-				} else {
-					logger::info("{} is missing", index);
-					missing += arg.name;
-					missing += " ";
-				}
+		stack.pop_back();
+
+		if (!valid) {
+			failed.insert(a_name);
+			return false;
+		}
+
+		expanded[a_name] = std::move(lines);
+		return true;
+	};
+
+	for (const auto& [name, body] : bodies) {
+		if (!expand(name))
+			continue;
+
+		Macro macro;
+		bool valid = true;
+
+		for (auto& tokens : expanded.at(name)) {
+			const auto cmd = GetCmd(tokens[0]);
+			if (!cmd) {
+				logger::error("macro {} references unknown command {}", name, tokens[0]);
+				valid = false;
+				break;
 			}
 
-			if (!missing.empty()) {
-				PrintErr(std::format("missing arguments {}", missing));
-				return true;
-			}		
-			
-			auto onResult = [](const RE::BSScript::Variable& a_var) {
-				using RawType = RE::BSScript::TypeInfo::RawType;
-				std::string ret;
-				
-				switch (a_var.GetType().GetRawType())
-				{
-				case RawType::kNone:
-					ret = "none";
-					break;
-				case RawType::kObject:
-					// TODO: implement
-					// maybe try to get the object, and then invoke GetFormID() on it?
-					ret = "completed";
-					break;
-				case RawType::kString:
-					ret = std::string{ a_var.GetString() };
-					break;
-				case RawType::kInt:
-					ret = std::to_string(a_var.GetSInt());
-					break;
-				case RawType::kFloat:
-					ret = std::to_string(a_var.GetFloat());
-					break;
-				case RawType::kBool:
-					ret = Util::BoolToString(a_var.GetBool());
-					break;
-				default:
-					// TODO: handle arrays
-					ret = "completed";
-					break;
-				}
-				logger::info("received callback value = {}", ret);
-				Print(ret);
-			};
+			auto& line = macro.lines.emplace_back();
+			line.tokens = tokens;
 
-			if (sub->close) {
-				if (const auto queue = RE::UIMessageQueue::GetSingleton()) {
-					queue->AddMessage(RE::Console::MENU_NAME, RE::UI_MESSAGE_TYPE::kHide, nullptr);
+			const auto params = Parser::CountParams(tokens);
+			macro.params = std::max(macro.params, params);
+
+			if (params > 0 || std::find(tokens.begin(), tokens.end(), "$*") != tokens.end())
+				continue;
+
+			// lines without parameters are bound once here and reused on every run
+			auto invocation = Parser::Bind(*cmd, tokens, false, false);
+			if (!invocation.help && !invocation.IsValid()) {
+				for (const auto& error : invocation.errors) {
+					logger::error("macro {}: {}", name, error);
 				}
+				valid = false;
+				break;
 			}
+			line.bound = std::move(invocation);
+		}
+
+		if (!valid)
+			continue;
+
+		const auto interned = StringPool::Intern(name);
+		logger::info("registering macro {} w/ {} lines", interned, macro.lines.size());
+		_macros[interned] = std::move(macro);
+		_names.Add(interned);
+	}
+}
+
+Commands::Entry* Commands::Register(std::string_view a_name, std::string_view a_alias, std::uint32_t a_file)
+{
+	const auto owner = [](std::string_view a_key) {
+		const auto it = _lookup.find(a_key);
+		return _files[_commands[it->second].file].path.filename().string();
+	};
 
-			Util::InvokeFuncWithArgs(cmd->script, sub->func, sub->args, values, a_ref, onResult);
+	if (a_name == Builtin) {
+		logger::error("{} is reserved for built-in commands - skipping", a_name);
+		return nullptr;
+	}
+
+	if (_lookup.count(a_name)) {
+		logger::error("{} already registered as a command - skipping", a_name);
+		_collisions.push_back(std::format("{}: command {} already registered by {}", _files[a_file].path.filename().string(), a_name, owner(a_name)));
+		return nullptr;
+	}
 
+	const auto index = static_cast<std::uint32_t>(_commands.size());
+	auto& entry = _commands.emplace_back();
+	entry.command.name = StringPool::Intern(a_name);
+	entry.command.alias = StringPool::Intern(a_alias);
+	entry.file = a_file;
+
+	_lookup[entry.command.name] = index;
+	_names.Add(entry.command.name);
+
+	if (!entry.command.alias.empty()) {
+		if (_lookup.count(entry.command.alias)) {
+			logger::error("{} command alias already registered as a command - skipping", entry.command.alias);
+			_collisions.push_back(std::format("{}: alias {} of {} already registered by {}", _files[a_file].path.filename().string(), entry.command.alias, entry.command.name, owner(entry.command.alias)));
 		} else {
-			PrintErr(std::format("invalid subcommand {}", tokens[1]));
-			return true;
+			_lookup[entry.command.alias] = index;
+			_names.Add(entry.command.alias);
+		}
+	}
+
+	return &entry;
+}
+
+Decoder::Result Commands::Decode(const fs::path& a_path)
+{
+	try {
+		auto result = Decoder::DecodeFile(a_path);
+		for (const auto& error : result.errors) {
+			logger::error("{}: {}", a_path.string(), error);
+		}
+
+		if (result.commands.empty()) {
+			logger::error("failed to create command from file: {}", a_path.string());
+		} else {
+			const auto& command = result.commands.front();
+			logger::info("registering command {} {} w/ {} subcommands", command.name, command.alias, command.subs.size());
+		}
+
+		return result;
+	} catch (std::exception& e) {
+		logger::error("failed to create command from file: {} due to {}", a_path.string(), e.what());
+	} catch (...) {
+		logger::error("failed to create command from file: {}", a_path.string());
+	}
+
+	return {};
+}
+
+bool Commands::Owns(std::string_view a_str)
+{
+	std::shared_lock lock{ _lock };
+	return _lookup.contains(a_str) || _macros.contains(a_str);
+}
+
+const Commands::Macro* Commands::GetMacro(std::string_view a_str)
+{
+	std::shared_lock lock{ _lock };
+	auto it = _macros.find(a_str);
+	return it != _macros.end() ? &it->second : nullptr;
+}
+
+const Command* Commands::GetCmd(std::string_view a_str)
+{
+	std::uint32_t index = 0;
+	fs::path path;
+
+	{
+		std::shared_lock lock{ _lock };
+
+		auto it = _lookup.find(a_str);
+		if (it == _lookup.end())
+			return nullptr;
+
+		index = it->second;
+		const auto& entry = _commands[index];
+		if (entry.loaded)
+			return &entry.command;
+		if (entry.failed)
+			return nullptr;
+
+		path = _files[entry.file].path;
+	}
+
+	// decoded outside the lock so ownership checks on the main thread never wait on file I/O
+	auto result = Decode(path);
+
+	std::unique_lock lock{ _lock };
+
+	auto& entry = _commands[index];
+	if (entry.loaded || entry.failed)
+		return entry.loaded ? &entry.command : nullptr;
+
+	auto& file = _files[entry.file];
+	file.decode = result.elapsed;
+	file.events = result.events;
+
+	for (auto& collision : result.collisions) {
+		_collisions.push_back(std::format("{}: {}", path.filename().string(), collision));
+	}
+
+	if (result.commands.empty()) {
+		entry.failed = true;
+		return nullptr;
+	}
+
+	// the scan stops at subs:, so anything declared past it is only found here, too late to register
+	if (result.commands.size() > 1)
+		logger::warn("{} holds {} commands but only {} was indexed - start the file with --- or a commands: list to load all of them", path.filename().string(), result.commands.size(), entry.command.name);
+	if (!result.macros.empty())
+		logger::warn("{} declares macros after subs: - move them above subs: so they are compiled at load", path.filename().string());
+
+	auto command = &result.commands.front();
+
+	if (command->name != entry.command.name)
+		logger::warn("{} was indexed as {} - keeping the indexed name", command->name, entry.command.name);
+
+	if (!command->alias.empty() && command->alias != entry.command.alias && !_lookup.count(command->alias)) {
+		_lookup[command->alias] = index;
+		_names.Add(command->alias);
+	}
+
+	command->name = entry.command.name;
+	entry.command = std::move(*command);
+	entry.loaded = true;
+
+	return &entry.command;
+}
+
+const Command* Commands::PeekCmd(std::string_view a_str)
+{
+	std::uint32_t index = 0;
+
+	{
+		std::shared_lock lock{ _lock };
+
+		const auto it = _lookup.find(a_str);
+		if (it == _lookup.end())
+			return nullptr;
+
+		index = it->second;
+		const auto& entry = _commands[index];
+		if (entry.loaded)
+			return &entry.command;
+		if (entry.failed || entry.queued)
+			return nullptr;
+	}
+
+	{
+		std::unique_lock lock{ _lock };
+		auto& entry = _commands[index];
+		if (entry.loaded || entry.failed || entry.queued)
+			return entry.loaded ? &entry.command : nullptr;
+		entry.queued = true;
+	}
+
+	Worker::Enqueue([name = std::string{ a_str }]() {
+		if (GetCmd(name))
+			_redraft = true;
+	});
+
+	return nullptr;
+}
+
+bool Commands::IsVanilla(std::string_view a_str)
+{
+	// vanilla commands can be called on a reference, e.g. player.additem
+	if (const auto dot = a_str.rfind('.'); dot != std::string_view::npos)
+		a_str = a_str.substr(dot + 1);
+
+	const auto matches = [a_str](const RE::SCRIPT_FUNCTION* a_commands, std::uint16_t a_count) {
+		for (std::uint16_t i = 0; a_commands && i < a_count; i++) {
+			const auto& command = a_commands[i];
+			if ((command.functionName && _strnicmp(command.functionName, a_str.data(), a_str.size()) == 0 && !command.functionName[a_str.size()]) ||
+				(command.shortName && _strnicmp(command.shortName, a_str.data(), a_str.size()) == 0 && !command.shortName[a_str.size()]))
+				return true;
+		}
+		return false;
+	};
+
+	using Table = RE::SCRIPT_FUNCTION::Commands;
+	return matches(RE::SCRIPT_FUNCTION::GetFirstConsoleCommand(), Table::kConsoleCommandsEnd) ||
+	       matches(RE::SCRIPT_FUNCTION::GetFirstScriptCommand(), Table::kScriptCommandsEnd);
+}
+
+bool Commands::RunBuiltin(const std::vector<std::string>& a_tokens, const Reply& a_reply)
+{
+	if (a_tokens[0] != Builtin)
+		return false;
+
+	// api submissions get the output through their reply
+	const auto output = [&a_reply](const std::string& a_str) {
+		if (a_reply)
+			a_reply(a_str, true);
+		else
+			Print(a_str);
+	};
+
+	const std::string_view sub = a_tokens.size() > 1 ? a_tokens[1] : std::string_view{};
+
+	if (sub == "record") {
+		// traces land next to redirected output, only the file name is kept
+		const auto file = a_tokens.size() > 2 ? fs::path{ a_tokens[2] }.filename().string() : std::string{ "session.c3t" };
+		Recorder::Start(file);
+		output(std::format("recording commands to {}", (Writer::GetDirectory() / file).string()));
+	} else if (sub == "stop") {
+		Recorder::Stop();
+		output("recording stopped");
+	} else if (sub == "profile") {
+		const auto report = Report();
+		logger::info("{}", report);
+		output(report);
+	} else {
+		output(std::format("usage: {0} record [file] | {0} stop | {0} profile", Builtin));
+	}
+
+	return true;
+}
+
+std::string Commands::Report()
+{
+	std::shared_lock lock{ _lock };
+
+	const auto ms = [](std::uint64_t a_ns) { return static_cast<double>(a_ns) / 1e6; };
+	const auto kb = [](std::size_t a_bytes) { return static_cast<double>(a_bytes) / 1024.0; };
+
+	struct Totals
+	{
+		std::size_t commands = 0;
+		std::size_t subs = 0;
+		std::size_t args = 0;
+		std::size_t bytes = 0;
+	};
+
+	std::vector<Totals> files(_files.size());
+	std::vector<std::pair<std::size_t, std::uint32_t>> sizes;  // bytes and entry index
+	sizes.reserve(_commands.size());
+	Totals all;
+	std::size_t decoded = 0;
+
+	for (const auto& entry : _commands) {
+		const auto& command = entry.command;
+
+		Totals totals{ 1, command.subs.size(), 0, GetBytes(command) };
+		for (const auto& sub : command.subs) {
+			totals.args += sub.args.size();
+		}
+
+		for (auto* sum : { &files[entry.file], &all }) {
+			sum->commands += totals.commands;
+			sum->subs += totals.subs;
+			sum->args += totals.args;
+			sum->bytes += totals.bytes;
+		}
+
+		sizes.emplace_back(totals.bytes, static_cast<std::uint32_t>(sizes.size()));
+		decoded += entry.loaded;
+	}
+
+	std::uint64_t scan = 0;
+	std::uint64_t decode = 0;
+	for (const auto& file : _files) {
+		scan += file.scan;
+		decode += file.decode;
+	}
+
+	std::string report;
+	report += std::format("registry profile: {} files, {} commands ({} decoded), {} subcommands, {} args, {} macros\n", _files.size(), all.commands, decoded, all.subs, all.args, _macros.size());
+	report += std::format("   load: scan {:.2f}ms, decode {:.2f}ms\n", ms(scan), ms(decode));
+	report += std::format("   memory: commands {:.1f}KB, string pool {:.1f}KB in {} strings\n", kb(all.bytes), kb(StringPool::GetBytes()), StringPool::GetCount());
+	report += std::format("   load factors: lookup {:.2f} ({}/{}), macros {:.2f} ({}/{}), string pool {:.2f}\n",
+		_lookup.load_factor(), _lookup.size(), _lookup.bucket_count(),
+		_macros.load_factor(), _macros.size(), _macros.bucket_count(),
+		StringPool::GetLoadFactor());
+
+	// slowest files first, they are the ones worth trimming
+	std::vector<std::uint32_t> order(_files.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::ranges::sort(order, std::greater{}, [](std::uint32_t a_index) { return _files[a_index].scan + _files[a_index].decode; });
+
+	report += "files:\n";
+	for (const auto index : order) {
+		const auto& file = _files[index];
+		const auto& totals = files[index];
+		report += std::format("   {}: scan {:.2f}ms, decode {}, {} events, {} commands, {} subcommands, {} args, {} macros, {:.1f}KB\n",
+			file.path.filename().string(), ms(file.scan),
+			file.lazy && !file.decode ? "deferred"s : std::format("{:.2f}ms", ms(file.decode)),
+			file.events, totals.commands, totals.subs, totals.args, file.macros, kb(totals.bytes));
+	}
+
+	// a big command is usually a long help text or a lot of args, either is cheap to trim
+	constexpr std::size_t largest = 10;
+	const auto count = std::min(largest, sizes.size());
+	std::ranges::partial_sort(sizes, sizes.begin() + count, std::greater{});
+
+	report += std::format("largest commands ({} of {}):\n", count, sizes.size());
+	for (std::size_t i = 0; i < count; i++) {
+		const auto& entry = _commands[sizes[i].second];
+		report += std::format("   {}: {:.1f}KB, {} subcommands, {}{}\n",
+			entry.command.name, kb(sizes[i].first), entry.command.subs.size(),
+			_files[entry.file].path.filename().string(), entry.loaded ? "" : " (deferred)");
+	}
+
+	if (!_collisions.empty()) {
+		report += std::format("collisions ({}):\n", _collisions.size());
+		for (const auto& collision : _collisions) {
+			report += std::format("   {}\n", collision);
 		}
+	}
+
+	return report;
+}
+
+std::size_t Commands::GetBytes(const Command& a_command)
+{
+	// strings are attributed to every command using them even though the pool shares duplicates
+	const auto str = [](std::string_view a_str) { return a_str.empty() ? 0 : a_str.size() + 1; };
 
+	// a lookup node holds the key, the index and the bucket chain link
+	constexpr auto node = sizeof(std::pair<const std::string_view, std::uint32_t>) + 2 * sizeof(void*);
+
+	std::size_t bytes = sizeof(Entry) + node * (a_command.alias.empty() ? 1 : 2);
+	bytes += str(a_command.name) + str(a_command.help) + str(a_command.alias) + str(a_command.script);
+	bytes += a_command.subs.capacity() * sizeof(SubCommand);
+
+	for (const auto& sub : a_command.subs) {
+		bytes += str(sub.name) + str(sub.func) + str(sub.help) + str(sub.alias);
+		bytes += sub.args.capacity() * sizeof(Arg);
+
+		for (const auto& arg : sub.args) {
+			bytes += str(arg.name) + str(arg.help) + str(arg.defaultVal) + str(arg.alias) + str(arg.rawType);
+			if (arg.validator)
+				bytes += sizeof(Validator);
+		}
+	}
+
+	return bytes;
+}
+
+bool Commands::Parse(const std::string& a_command, RE::TESObjectREFR* a_ref)
+{
+	// a line typed into the console was already tokenized, and usually bound, while it was typed
+	// script natives such as ConsoleUtil's ExecuteCommand land here on VM threads and never see the draft
+	const bool drafted = std::this_thread::get_id() == _console.load() && _draft.Matches(a_command, a_ref != nullptr);
+	auto tokens = drafted ? _draft.GetTokens() : Parser::Tokenize(a_command);
+
+	if (tokens.empty())
+		return false;
+
+	if (RunBuiltin(tokens, {}))
 		return true;
+
+	if (!Owns(tokens[0])) {
+		// a near miss on one of our commands is probably a typo, but other plugins may still own the line so the game sees it too
+		if (!IsVanilla(tokens[0])) {
+			std::unique_lock lock{ _lock };
+			if (const auto suggestions = _names.Suggest(tokens[0]); !suggestions.empty())
+				PrintErr(std::format("{} is not a custom command - did you mean {}?", tokens[0], Fuzzy::Join(suggestions)));
+		}
+
+		return false;
+	}
+
+	// only the ownership check happens on the main thread, binding and form lookups run on the worker
+	const auto target = a_ref ? a_ref->CreateRefHandle() : RE::ObjectRefHandle{};
+	const auto targetID = a_ref ? a_ref->GetFormID() : 0;
+
+	auto trace = Recorder::Begin(a_command, targetID);
+
+	if (drafted && _draft.invocation) {
+		// the preview bound quietly, the submitted line is logged once here instead
+		logger::info("command {} recognized", _draft.invocation->cmd->name);
+		if (_draft.invocation->sub)
+			logger::info("subcommand {} recognized", _draft.invocation->sub->name);
+		if (trace)
+			trace->bind = _draft.bind;
+
+		Worker::Enqueue([invocation = std::move(*_draft.invocation), target, targetID, trace = std::move(trace)]() mutable {
+			std::vector<Call> batch;
+			if (Prepare(std::move(invocation), targetID, batch, std::move(trace)))
+				Submit(std::move(batch), target);
+		});
+		_draft.Clear();
+		return true;
+	}
+
+	auto redirect = Parser::ExtractRedirect(tokens, a_command);
+
+	Worker::Enqueue([tokens = std::move(tokens), redirect = std::move(redirect), target, targetID, trace = std::move(trace)]() mutable {
+		Execute(std::move(tokens), std::move(redirect), target, targetID, std::move(trace), {});
+	});
+
+	return true;
+}
+
+const std::string& Commands::Preview(std::string_view a_line, bool a_hasRef)
+{
+	_console = std::this_thread::get_id();
+
+	const bool redraft = _redraft.exchange(false);
+	if (!_draft.Update(a_line, a_hasRef) && !redraft)
+		return _draft.status;
+
+	_draft.invocation.reset();
+	_draft.status.clear();
+	_draft.bind = 0;
+
+	// macros and builtins are expanded on submit, vanilla commands are left to the game
+	auto tokens = _draft.GetTokens();
+	if (tokens.empty() || tokens[0] == Builtin || !Owns(tokens[0]) || GetMacro(tokens[0]))
+		return _draft.status;
+
+	auto redirect = Parser::ExtractRedirect(tokens, a_line);
+
+	// a command not decoded yet shows no status until the worker is done with it
+	const auto cmd = PeekCmd(tokens[0]);
+	if (!cmd)
+		return _draft.status;
+
+	const auto start = Recorder::Clock::now();
+	auto invocation = Parser::Bind(*cmd, tokens, a_hasRef, true);
+	invocation.redirect = std::move(redirect);
+	_draft.bind = Recorder::Elapsed(start);
+
+	if (!invocation.help) {
+		if (!invocation.IsValid())
+			_draft.status = invocation.errors.front();
+		else if (const auto& dispatch = Dispatcher::Get(*cmd, *invocation.sub); !dispatch.IsValid())
+			_draft.status = dispatch.error;
 	}
 
+	_draft.invocation = std::move(invocation);
+	return _draft.status;
+}
+
+bool Commands::Enqueue(std::string a_line, RE::FormID a_target, Reply a_reply)
+{
+	Submission submission{ std::move(a_line), a_target, std::move(a_reply) };
+	if (_submissions.TryPush(submission))
+		return true;
+
+	logger::warn("submission queue full - dropping {}", submission.line);
 	return false;
 }
 
+void Commands::Drain()
+{
+	// bounded per frame so a flood of submissions never stalls a single frame
+	std::vector<std::function<void()>> jobs;
+
+	for (std::size_t i = 0; i < BatchSize; i++) {
+		auto submission = _submissions.TryPop();
+		if (!submission)
+			break;
+
+		auto tokens = Parser::Tokenize(submission->line);
+		if (tokens.empty()) {
+			Reject(submission->reply, "empty command");
+			continue;
+		}
+
+		if (RunBuiltin(tokens, submission->reply))
+			continue;
+
+		// vanilla lines need the game's compiler and console context, which only the console itself provides
+		if (!Owns(tokens[0])) {
+			Reject(submission->reply, std::format("{} is not a custom command - vanilla console commands cannot be submitted", tokens[0]));
+			continue;
+		}
+
+		// refs are looked up and pinned here, the worker only ever sees the handle
+		const auto ref = submission->target ? RE::TESForm::LookupByID<RE::TESObjectREFR>(submission->target) : nullptr;
+		const auto target = ref ? ref->CreateRefHandle() : RE::ObjectRefHandle{};
+		const auto targetID = ref ? ref->GetFormID() : 0;
+
+		auto trace = Recorder::Begin(submission->line, targetID);
+		auto redirect = Parser::ExtractRedirect(tokens, submission->line);
+
+		jobs.push_back([tokens = std::move(tokens), redirect = std::move(redirect), target, targetID, trace = std::move(trace), reply = std::move(submission->reply)]() mutable {
+			Execute(std::move(tokens), std::move(redirect), target, targetID, std::move(trace), std::move(reply));
+		});
+	}
+
+	if (jobs.empty())
+		return;
+
+	// one hop to the worker per batch rather than per line
+	Worker::Enqueue([jobs = std::move(jobs)]() {
+		for (const auto& job : jobs) {
+			job();
+		}
+	});
+}
+
+void Commands::Execute(std::vector<std::string> a_tokens, std::optional<Redirect> a_redirect, RE::ObjectRefHandle a_target, RE::FormID a_targetID, std::optional<Trace::Record> a_trace, Reply a_reply)
+{
+	if (const auto macro = GetMacro(a_tokens[0])) {
+		ExecuteMacro(*macro, a_tokens, a_redirect, a_target, a_targetID, a_trace, a_reply);
+		return;
+	}
+
+	const auto cmd = GetCmd(a_tokens[0]);
+	if (!cmd) {
+		const auto error = std::format("failed to load command {}", a_tokens[0]);
+		Reject(a_reply, error);
+		if (a_trace)
+			Recorder::Finish(std::move(*a_trace), error, Trace::Status::Error);
+		return;
+	}
+
+	logger::info("command {} recognized", cmd->name);
+
+	const auto start = Recorder::Clock::now();
+	auto invocation = Parser::Bind(*cmd, a_tokens, a_targetID != 0, false);
+	invocation.redirect = std::move(a_redirect);
+	invocation.reply = std::move(a_reply);
+
+	if (a_trace)
+		a_trace->bind = Recorder::Elapsed(start);
+
+	std::vector<Call> batch;
+	if (Prepare(std::move(invocation), a_targetID, batch, std::move(a_trace)))
+		Submit(std::move(batch), a_target);
+}
+
+void Commands::ExecuteMacro(const Macro& a_macro, const std::vector<std::string>& a_tokens, const std::optional<Redirect>& a_redirect, RE::ObjectRefHandle a_target, RE::FormID a_targetID, const std::optional<Trace::Record>& a_trace, const Reply& a_reply)
+{
+	const std::vector<std::string> args{ a_tokens.begin() + 1, a_tokens.end() };
+	if (args.size() < a_macro.params) {
+		Reject(a_reply, std::format("{} expects {} arguments but got {}", a_tokens[0], a_macro.params, args.size()));
+		return;
+	}
+
+	// the whole macro is bound up front and dispatched as one batch, a bad line cancels all of it
+	// nothing is output until every line is accepted, results and help are held in the calls until dispatch
+	std::vector<Call> batch;
+	const auto cancel = [&batch](const std::string& a_error) {
+		for (auto& call : batch) {
+			if (call.trace)
+				Recorder::Finish(std::move(*call.trace), a_error, Trace::Status::Error);
+		}
+	};
+
+	// every line appends to a redirect, so a truncating one is truncated once before the batch runs
+	std::optional<Redirect> redirect;
+	if (a_redirect) {
+		redirect = a_redirect;
+		redirect->append = true;
+	}
+
+	for (const auto& line : a_macro.lines) {
+		Invocation invocation;
+
+		// each expanded line is traced on its own so the replayer never needs the macro table
+		auto trace = a_trace;
+
+		// pre-bound lines were bound without a selection, so rebind if they would pick it up
+		// help lines are bound without a sub and never take one
+		if (line.bound && !(a_targetID && line.bound->sub && line.bound->sub->GetSelected())) {
+			invocation = *line.bound;
+			if (trace)
+				trace->line = Parser::Join(line.tokens);
+		} else {
+			const auto tokens = Parser::Substitute(line.tokens, args);
+			const auto cmd = GetCmd(tokens[0]);
+			if (!cmd) {
+				const auto error = std::format("failed to load command {}", tokens[0]);
+				Reject(a_reply, error);
+				cancel(error);
+				return;
+			}
+
+			const auto start = Recorder::Clock::now();
+			invocation = Parser::Bind(*cmd, tokens, a_targetID != 0, false);
+
+			if (trace) {
+				trace->bind = Recorder::Elapsed(start);
+				trace->line = Parser::Join(tokens);
+			}
+		}
+
+		invocation.redirect = redirect;
+		invocation.reply = a_reply;
+		if (!Prepare(std::move(invocation), a_targetID, batch, std::move(trace))) {
+			cancel(std::format("cancelled, {} failed", Parser::Join(line.tokens)));
+			return;
+		}
+	}
+
+	if (a_redirect && !a_redirect->append)
+		Writer::Write(fs::path{ a_redirect->path }.filename().string(), {}, false);
+
+	Submit(std::move(batch), a_target);
+}
+
+bool Commands::Prepare(Invocation a_invocation, RE::FormID a_targetID, std::vector<Call>& a_batch, std::optional<Trace::Record> a_trace)
+{
+	const auto cmd = a_invocation.cmd;
+
+	if (a_trace) {
+		a_trace->cmd = cmd->name;
+		a_trace->sub = a_invocation.sub ? a_invocation.sub->name : std::string_view{};
+		a_trace->values = a_invocation.values;
+	}
+
+	const auto finish = [&a_trace](std::string_view a_result, Trace::Status a_status) {
+		if (a_trace)
+			Recorder::Finish(std::move(*a_trace), a_result, a_status);
+	};
+
+	// answered without the VM, but still output from dispatch so a macro never prints before its batch is accepted
+	const auto answer = [&](std::string a_result, Trace::Status a_status) {
+		Call call;
+		call.invocation = std::move(a_invocation);
+		call.trace = std::move(a_trace);
+		call.result = std::move(a_result);
+		call.status = a_status;
+		a_batch.push_back(std::move(call));
+		return true;
+	};
+
+	if (a_invocation.help)
+		return answer(cmd->Help(), Trace::Status::Help);
+
+	if (!a_invocation.IsValid()) {
+		std::string errors;
+		for (const auto& error : a_invocation.errors) {
+			if (!errors.empty())
+				errors += "\n";
+			errors += error;
+		}
+
+		Reject(a_invocation.reply, errors);
+		finish(errors, Trace::Status::Error);
+		return false;
+	}
+
+	const auto sub = a_invocation.sub;
+
+	Call call;
+
+	if (sub->IsCached()) {
+		call.key = Cache::MakeKey(*cmd, *sub, a_invocation.values, a_targetID);
+		if (auto result = Cache::Get(call.key)) {
+			logger::info("returning cached result for {} {}", cmd->name, sub->name);
+			return answer(std::move(*result), Trace::Status::Cached);
+		}
+	}
+
+	call.formIDs.resize(sub->args.size());
+	for (std::size_t i = 0; i < sub->args.size(); i++) {
+		const auto& arg = sub->args[i];
+		const auto forms = Util::ResolveForms(arg, a_invocation.values[i]);
+		const auto formType = arg.validator ? arg.validator->GetFormType() : std::string_view{};
+
+		for (const auto form : forms) {
+			if (!formType.empty() && !Util::IsFormType(form, formType)) {
+				const auto error = std::format("{}: {:08X} is not a {}", arg.name, form->GetFormID(), formType);
+				Reject(a_invocation.reply, error);
+				finish(error, Trace::Status::Error);
+				return false;
+			}
+
+			call.formIDs[i].push_back(form->GetFormID());
+		}
+	}
+
+	call.invocation = std::move(a_invocation);
+	call.trace = std::move(a_trace);
+	a_batch.push_back(std::move(call));
+	return true;
+}
+
+void Commands::Submit(std::vector<Call> a_batch, RE::ObjectRefHandle a_target)
+{
+	if (a_batch.empty())
+		return;
+
+	// the VM and script object handles are engine-affine, so hop back to the main thread for dispatch
+	SKSE::GetTaskInterface()->AddTask([batch = std::move(a_batch), a_target]() {
+		for (const auto& call : batch) {
+			Dispatch(call, a_target);
+		}
+	});
+}
+
+void Commands::Dispatch(const Call& a_call, RE::ObjectRefHandle a_target)
+{
+	const auto& invocation = a_call.invocation;
+	const auto cmd = invocation.cmd;
+	const auto sub = invocation.sub;
+
+	if (a_call.result) {
+		if (a_call.status == Trace::Status::Cached && sub->close)
+			CloseConsole();
+		Output(invocation, *a_call.result);
+		if (a_call.trace)
+			Recorder::Finish(*a_call.trace, *a_call.result, a_call.status);
+		return;
+	}
+
+	if (sub->close)
+		CloseConsole();
+
+	auto onResult = [key = a_call.key, ttl = sub->ttl, invocation, trace = a_call.trace](const RE::BSScript::Variable& a_var) {
+		const auto ret = Util::VariableToString(a_var);
+		logger::info("received callback value = {}", ret);
+		if (!key.empty())
+			Cache::Put(key, ret, ttl);
+		Output(invocation, ret);
+		if (trace)
+			Recorder::Finish(*trace, ret, Trace::Status::Ok);
+	};
+
+	// failed dispatches are traced too, so a replay can tell them apart from lines that never ran
+	const auto fail = [&](const std::string& a_error) {
+		Reject(invocation.reply, a_error);
+		if (a_call.trace)
+			Recorder::Finish(*a_call.trace, a_error, Trace::Status::Error);
+	};
+
+	const auto& dispatch = Dispatcher::Get(*cmd, *sub);
+	if (!dispatch.IsValid()) {
+		fail(std::format("{}.{}: {}", cmd->script, sub->func, dispatch.error));
+		return;
+	}
+
+	std::vector<std::vector<RE::TESForm*>> forms(a_call.formIDs.size());
+	for (std::size_t i = 0; i < a_call.formIDs.size(); i++) {
+		for (const auto formID : a_call.formIDs[i]) {
+			const auto form = RE::TESForm::LookupByID(formID);
+			if (!form) {
+				fail(std::format("{}: {:08X} no longer exists", sub->args[i].name, formID));
+				return;
+			}
+			forms[i].push_back(form);
+		}
+	}
+
+	const auto target = a_target.get();
+	if (!Util::InvokeFuncWithArgs(dispatch, sub->args, invocation.values, forms, target.get(), onResult))
+		fail(std::format("failed to dispatch {}.{}", cmd->script, sub->func));
+}
+
+void Commands::Output(const Invocation& a_invocation, const std::string& a_str)
+{
+	if (a_invocation.reply) {
+		a_invocation.reply(a_str, true);
+		return;
+	}
+
+	if (!a_invocation.redirect) {
+		Print(a_str);
+		return;
+	}
+
+	// only the file name is kept so redirects always land in the plugin's log directory
+	const auto& redirect = *a_invocation.redirect;
+	Writer::Write(fs::path{ redirect.path }.filename().string(), a_str + '\n', redirect.append);
+}
+
+void Commands::Reject(const Reply& a_reply, const std::string& a_error)
+{
+	if (!a_reply) {
+		PrintErr(a_error);
+		return;
+	}
+
+	logger::error("{}", a_error);
+	a_reply(a_error, false);
+}
+
+void Commands::CloseConsole()
+{
+	if (const auto queue = RE::UIMessageQueue::GetSingleton()) {
+		queue->AddMessage(RE::Console::MENU_NAME, RE::UI_MESSAGE_TYPE::kHide, nullptr);
+	}
+}
+
 void Commands::Print(const std::string& a_str)
 {
 	std::string str{ stl::safe_string(a_str.c_str()) };
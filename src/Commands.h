@@ -1,6 +1,12 @@
 #pragma once
 
 #include "Command.h"
+#include "Decoder.h"
+#include "Draft.h"
+#include "Fuzzy.h"
+#include "Parser.h"
+#include "Ring.h"
+#include "Trace.h"
 
 namespace C3
 {
@@ -8,12 +14,131 @@ namespace C3
 	{
 	public:
 		static void Load();
+		// checks every subcommand against its papyrus function once scripts are available, lazily registered ones after a background decode
+		static void Resolve();
 		static bool Parse(const std::string& a_command, RE::TESObjectREFR* a_ref);
+		// binds the console line as it is typed, returns why it would be rejected or an empty string
+		static const std::string& Preview(std::string_view a_line, bool a_hasRef);
+
+		// thread-safe and lock-free, false when the queue is full
+		// runs custom commands, macros and the c3 builtins, vanilla lines are rejected through a_reply
+		static bool Enqueue(std::string a_line, RE::FormID a_target, Reply a_reply);
+		// main thread only, called once per frame
+		static void Drain();
 	private:
 		static void Print(const std::string& a_str);
 		static void PrintErr(std::string a_str);
-		static inline Command* GetCmd(std::string a_str) { return _commands.count(a_str) ? &_commands[a_str] : nullptr; }
 
-		static inline std::unordered_map<std::string, Command> _commands;
+		struct Entry
+		{
+			Command command;
+			std::uint32_t file = 0;
+			bool loaded = false;
+			bool failed = false;
+			bool queued = false;  // handed to the worker for decoding by a console preview
+		};
+
+		// load cost of one definition file, lazily decoded files fill in decode on first use
+		struct File
+		{
+			std::filesystem::path path;
+			std::uint64_t scan = 0;
+			std::uint64_t decode = 0;
+			std::size_t events = 0;
+			std::size_t macros = 0;
+			bool lazy = false;
+		};
+
+		struct Header
+		{
+			std::string name;
+			std::string alias;
+			bool macros = false;
+			bool bundle = false;
+		};
+
+		// a macro flattened into command lines, those without parameters are bound at load
+		struct Macro
+		{
+			struct Line
+			{
+				std::vector<std::string> tokens;
+				std::optional<Invocation> bound;
+			};
+
+			std::vector<Line> lines;
+			std::size_t params = 0;
+		};
+
+		// an invocation bound and resolved on the worker, ready for dispatch on the main thread
+		// forms travel as ids since a load or deletion may free them before the main thread runs the call
+		struct Call
+		{
+			Invocation invocation;
+			std::vector<std::vector<RE::FormID>> formIDs;
+			std::string key;
+			std::optional<Trace::Record> trace;
+			std::optional<std::string> result;  // help or a cached result, output at dispatch without calling the VM
+			Trace::Status status = Trace::Status::Ok;
+		};
+
+		// a line submitted through the papyrus or plugin api, waiting for the main thread
+		struct Submission
+		{
+			std::string line;
+			RE::FormID target = 0;
+			Reply reply;
+		};
+
+		static constexpr std::size_t QueueSize = 4096;
+		static constexpr std::size_t BatchSize = 256;
+
+		// reserved for the plugin's own commands, e.g. c3 record
+		static constexpr std::string_view Builtin = "c3";
+
+		static Header Scan(const std::filesystem::path& a_path);
+		static void CompileMacros(const std::vector<std::pair<std::string, std::string>>& a_sources);
+		static Entry* Register(std::string_view a_name, std::string_view a_alias, std::uint32_t a_file);
+		static Decoder::Result Decode(const std::filesystem::path& a_path);
+		// resolves the dispatch target of every subcommand on the main thread, logging how many were rejected
+		static void CheckTargets(const std::vector<const Command*>& a_commands, std::string_view a_kind);
+		static bool Owns(std::string_view a_str);
+		static const Command* GetCmd(std::string_view a_str);
+		// never decodes on the calling thread, an undecoded command is queued on the worker and null until it is done
+		static const Command* PeekCmd(std::string_view a_str);
+		static const Macro* GetMacro(std::string_view a_str);
+		static bool IsVanilla(std::string_view a_str);
+		static bool RunBuiltin(const std::vector<std::string>& a_tokens, const Reply& a_reply);
+		static std::string Report();
+		static std::size_t GetBytes(const Command& a_command);
+
+		static void Execute(std::vector<std::string> a_tokens, std::optional<Redirect> a_redirect, RE::ObjectRefHandle a_target, RE::FormID a_targetID, std::optional<Trace::Record> a_trace, Reply a_reply);
+		static void ExecuteMacro(const Macro& a_macro, const std::vector<std::string>& a_tokens, const std::optional<Redirect>& a_redirect, RE::ObjectRefHandle a_target, RE::FormID a_targetID, const std::optional<Trace::Record>& a_trace, const Reply& a_reply);
+		static bool Prepare(Invocation a_invocation, RE::FormID a_targetID, std::vector<Call>& a_batch, std::optional<Trace::Record> a_trace);
+		static void Submit(std::vector<Call> a_batch, RE::ObjectRefHandle a_target);
+		static void Dispatch(const Call& a_call, RE::ObjectRefHandle a_target);
+		static void Output(const Invocation& a_invocation, const std::string& a_str);
+		static void Reject(const Reply& a_reply, const std::string& a_error);
+		static void CloseConsole();
+
+		// guards the lookup tables against lazy decoding on the worker
+		static inline std::shared_mutex _lock;
+
+		// every command is stored once, names and aliases index into it
+		static inline std::vector<Entry> _commands;
+		static inline std::unordered_map<std::string_view, std::uint32_t> _lookup;
+		static inline std::unordered_map<std::string_view, Macro> _macros;
+		static inline Fuzzy::Index _names;
+
+		static inline std::vector<File> _files;
+		static inline std::vector<std::string> _collisions;
+
+		static inline Ring<Submission, QueueSize> _submissions;
+
+		// only touched on the thread the console previews from, Parse called from anywhere else ignores it
+		static inline Draft _draft;
+		static inline std::atomic<std::thread::id> _console;
+		// set by the worker when a previewed command finished decoding, so the unchanged line is bound again
+		static inline std::atomic<bool> _redraft = false;
 	};
-}
\ No newline at end of file
+}
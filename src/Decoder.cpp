@@ -0,0 +1,668 @@
+#include "Decoder.h"
+#include "StringPool.h"
+
+#include "yaml-cpp/eventhandler.h"
+
+using namespace C3;
+
+namespace
+{
+	// yaml-cpp reports keys and values alike as scalars, so map levels track which one is next
+	// anchored nodes are recorded as they stream past and replayed for each alias, a "<<" merge splices in the aliased map's entries
+	class YamlHandler : public YAML::EventHandler
+	{
+	public:
+		explicit YamlHandler(Decoder& a_decoder) :
+			_decoder(a_decoder) {}
+
+		void OnDocumentStart(const YAML::Mark&) override {}
+		void OnDocumentEnd() override { _anchors.clear(); }
+
+		void OnNull(const YAML::Mark&, YAML::anchor_t a_anchor) override { OnValue({}, a_anchor); }
+		void OnAlias(const YAML::Mark&, YAML::anchor_t a_anchor) override { Replay(a_anchor); }
+		void OnScalar(const YAML::Mark&, const std::string&, YAML::anchor_t a_anchor, const std::string& a_value) override { OnValue(a_value, a_anchor); }
+
+		void OnSequenceStart(const YAML::Mark&, const std::string&, YAML::anchor_t a_anchor, YAML::EmitterStyle::value) override
+		{
+			if (a_anchor)
+				_recordings.push_back({ a_anchor, 0, {} });
+			Handle({ Event::Type::SeqStart, {} });
+		}
+
+		void OnSequenceEnd() override { Handle({ Event::Type::SeqEnd, {} }); }
+
+		void OnMapStart(const YAML::Mark&, const std::string&, YAML::anchor_t a_anchor, YAML::EmitterStyle::value) override
+		{
+			if (a_anchor)
+				_recordings.push_back({ a_anchor, 0, {} });
+			Handle({ Event::Type::MapStart, {} });
+		}
+
+		void OnMapEnd() override { Handle({ Event::Type::MapEnd, {} }); }
+
+	private:
+		struct Level
+		{
+			bool map;
+			bool key;
+			std::vector<std::string> keys;  // seen so far, merged entries never override them
+		};
+
+		struct Event
+		{
+			enum class Type : std::uint8_t
+			{
+				MapStart,
+				MapEnd,
+				SeqStart,
+				SeqEnd,
+				Scalar,
+			};
+
+			Type type;
+			std::string value;
+		};
+
+		struct Recording
+		{
+			YAML::anchor_t anchor;
+			std::size_t depth;
+			std::vector<Event> events;
+		};
+
+		void OnValue(std::string_view a_value, YAML::anchor_t a_anchor)
+		{
+			Event event{ Event::Type::Scalar, std::string{ a_value } };
+			Handle(event);
+			if (a_anchor)
+				_anchors[a_anchor] = { std::move(event) };
+		}
+
+		void Handle(const Event& a_event)
+		{
+			const bool key = !_levels.empty() && _levels.back().map && _levels.back().key;
+
+			// the merge key itself is never recorded, recordings hold the merged entries instead
+			if (key && a_event.type == Event::Type::Scalar && a_event.value == "<<") {
+				_levels.back().key = false;
+				_merge = true;
+				return;
+			}
+
+			if (_merge) {
+				_merge = false;
+				_decoder.Fail("<< only merges a single alias of a map");
+				_decoder.Key("<<");
+			}
+
+			Record(a_event);
+
+			switch (a_event.type) {
+			case Event::Type::MapStart:
+				Advance();
+				_levels.push_back({ true, true, {} });
+				_decoder.StartMap();
+				break;
+			case Event::Type::SeqStart:
+				Advance();
+				_levels.push_back({ false, false, {} });
+				_decoder.StartSeq();
+				break;
+			case Event::Type::MapEnd:
+				_levels.pop_back();
+				_decoder.EndMap();
+				break;
+			case Event::Type::SeqEnd:
+				_levels.pop_back();
+				_decoder.EndSeq();
+				break;
+			case Event::Type::Scalar:
+				if (key) {
+					_levels.back().key = false;
+					_levels.back().keys.push_back(a_event.value);
+					_decoder.Key(a_event.value);
+				} else {
+					Advance();
+					_decoder.Scalar(a_event.value);
+				}
+				break;
+			}
+		}
+
+		void Replay(YAML::anchor_t a_anchor)
+		{
+			const auto it = _anchors.find(a_anchor);
+			if (it == _anchors.end()) {
+				_decoder.Fail("alias to an unknown anchor");
+				Handle({ Event::Type::Scalar, {} });
+				return;
+			}
+
+			// copied, replaying may finish enclosing recordings and grow the anchor table
+			const auto events = it->second;
+
+			if (_merge && events.front().type == Event::Type::MapStart) {
+				_merge = false;
+				_levels.back().key = true;
+				for (std::size_t i = 1; i + 1 < events.size();) {
+					// a merged entry is its key plus one scalar or one whole collection
+					auto end = i + 2;
+					for (std::size_t depth = 0; end - 1 < events.size(); end++) {
+						const auto type = events[end - 1].type;
+						if (type == Event::Type::MapStart || type == Event::Type::SeqStart)
+							depth++;
+						else if (type == Event::Type::MapEnd || type == Event::Type::SeqEnd)
+							depth--;
+						if (depth == 0)
+							break;
+					}
+
+					const auto& keys = _levels.back().keys;
+					if (std::ranges::find(keys, events[i].value) == keys.end()) {
+						for (auto j = i; j < end; j++) {
+							Handle(events[j]);
+						}
+					}
+					i = end;
+				}
+				return;
+			}
+
+			for (const auto& event : events) {
+				Handle(event);
+			}
+		}
+
+		// every open recording sees the event, the innermost one is complete once its node closes
+		void Record(const Event& a_event)
+		{
+			for (auto& recording : _recordings) {
+				recording.events.push_back(a_event);
+				if (a_event.type == Event::Type::MapStart || a_event.type == Event::Type::SeqStart)
+					recording.depth++;
+				else if (a_event.type == Event::Type::MapEnd || a_event.type == Event::Type::SeqEnd)
+					recording.depth--;
+			}
+
+			while (!_recordings.empty() && _recordings.back().depth == 0 && !_recordings.back().events.empty()) {
+				_anchors[_recordings.back().anchor] = std::move(_recordings.back().events);
+				_recordings.pop_back();
+			}
+		}
+
+		// a value was consumed, so the enclosing map expects a key next
+		void Advance()
+		{
+			if (!_levels.empty() && _levels.back().map)
+				_levels.back().key = true;
+		}
+
+		Decoder& _decoder;
+		std::vector<Level> _levels;
+		std::vector<Recording> _recordings;
+		std::unordered_map<YAML::anchor_t, std::vector<Event>> _anchors;
+		bool _merge = false;
+	};
+
+	class JsonHandler : public nlohmann::json_sax<json>
+	{
+	public:
+		explicit JsonHandler(Decoder& a_decoder) :
+			_decoder(a_decoder) {}
+
+		bool null() override { return Scalar({}); }
+		bool boolean(bool a_value) override { return Scalar(a_value ? "true" : "false"); }
+		bool number_integer(number_integer_t a_value) override { return Scalar(std::to_string(a_value)); }
+		bool number_unsigned(number_unsigned_t a_value) override { return Scalar(std::to_string(a_value)); }
+		bool number_float(number_float_t, const string_t& a_raw) override { return Scalar(a_raw); }
+		bool string(string_t& a_value) override { return Scalar(a_value); }
+		bool binary(binary_t&) override { return Scalar({}); }
+
+		bool start_object(std::size_t) override
+		{
+			_decoder.StartMap();
+			return true;
+		}
+
+		bool end_object() override
+		{
+			_decoder.EndMap();
+			return true;
+		}
+
+		bool start_array(std::size_t) override
+		{
+			_decoder.StartSeq();
+			return true;
+		}
+
+		bool end_array() override
+		{
+			_decoder.EndSeq();
+			return true;
+		}
+
+		bool key(string_t& a_key) override
+		{
+			_decoder.Key(a_key);
+			return true;
+		}
+
+		bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& a_error) override
+		{
+			throw std::runtime_error(a_error.what());
+		}
+
+	private:
+		bool Scalar(std::string_view a_value)
+		{
+			_decoder.Scalar(a_value);
+			return true;
+		}
+
+		Decoder& _decoder;
+	};
+
+	std::string_view Trim(std::string_view a_str)
+	{
+		const auto first = a_str.find_first_not_of(" \t");
+		const auto last = a_str.find_last_not_of(" \t");
+		return first == std::string_view::npos ? std::string_view{} : a_str.substr(first, last - first + 1);
+	}
+
+	std::optional<double> ToNumber(std::string_view a_str)
+	{
+		if (a_str.starts_with('+'))
+			a_str.remove_prefix(1);
+
+		double value = 0.0;
+		const auto [ptr, ec] = std::from_chars(a_str.data(), a_str.data() + a_str.size(), value);
+		if (ec != std::errc{} || ptr != a_str.data() + a_str.size())
+			return std::nullopt;
+		return value;
+	}
+}
+
+Decoder::Result Decoder::DecodeFile(const std::filesystem::path& a_path)
+{
+	std::ifstream file{ a_path, std::ios::binary };
+	if (!file)
+		throw std::runtime_error("could not open file");
+
+	const auto start = std::chrono::steady_clock::now();
+	auto result = a_path.extension() == ".json" ? DecodeJson(file) : DecodeYaml(file);
+	result.elapsed = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+
+	return result;
+}
+
+Decoder::Result Decoder::DecodeYaml(std::istream& a_stream)
+{
+	Decoder decoder;
+	YamlHandler handler{ decoder };
+
+	YAML::Parser parser{ a_stream };
+	while (parser.HandleNextDocument(handler)) {}
+
+	return decoder.Take();
+}
+
+Decoder::Result Decoder::DecodeJson(std::istream& a_stream)
+{
+	Decoder decoder;
+	JsonHandler handler{ decoder };
+
+	json::sax_parse(a_stream, &handler);
+
+	return decoder.Take();
+}
+
+void Decoder::StartMap()
+{
+	_result.events++;
+
+	if (_stack.empty()) {
+		// each document is either a command or a wrapper around "commands:" and "macros:"
+		_command = {};
+		_failed = false;
+		_bundle = false;
+		_macros = false;
+		Push(Frame::Document);
+		return;
+	}
+
+	const auto& top = _stack.back();
+	switch (top.frame) {
+	case Frame::Document:
+		if (top.key == "macros") {
+			_macros = true;
+			Push(Frame::MacroMap);
+		} else {
+			Push(Frame::Skip);
+		}
+		break;
+	case Frame::CommandList:
+		_command = {};
+		_failed = false;
+		Push(Frame::Command);
+		break;
+	case Frame::SubList:
+		_sub = {};
+		Push(Frame::Sub);
+		break;
+	case Frame::ArgList:
+		_arg = {};
+		_spec = {};
+		Push(Frame::Arg);
+		break;
+	default:
+		Push(Frame::Skip);
+		break;
+	}
+}
+
+void Decoder::EndMap()
+{
+	_result.events++;
+
+	const auto frame = _stack.back().frame;
+	Pop();
+
+	switch (frame) {
+	case Frame::Document:
+		// a document holding only macros or a command list is not a command itself
+		if (!_bundle && !(_macros && _command.name.empty()))
+			FinishCommand();
+		break;
+	case Frame::Command:
+		FinishCommand();
+		break;
+	case Frame::Sub:
+		FinishSub();
+		break;
+	case Frame::Arg:
+		FinishArg();
+		break;
+	default:
+		break;
+	}
+}
+
+void Decoder::StartSeq()
+{
+	_result.events++;
+
+	if (_stack.empty()) {
+		_bundle = true;
+		Push(Frame::CommandList);
+		return;
+	}
+
+	const auto& top = _stack.back();
+	switch (top.frame) {
+	case Frame::Document:
+		if (top.key == "commands") {
+			_bundle = true;
+			Push(Frame::CommandList);
+		} else if (top.key == "subs") {
+			Push(Frame::SubList);
+		} else if (top.key == "macro") {
+			_macros = true;
+			Push(Frame::MacroList);
+		} else {
+			Push(Frame::Skip);
+		}
+		break;
+	case Frame::Command:
+		Push(top.key == "subs" ? Frame::SubList : Frame::Skip);
+		break;
+	case Frame::Sub:
+		Push(top.key == "args" ? Frame::ArgList : Frame::Skip);
+		break;
+	case Frame::Arg:
+		Push(top.key == "choices" ? Frame::Choices : Frame::Skip);
+		break;
+	default:
+		Push(Frame::Skip);
+		break;
+	}
+}
+
+void Decoder::EndSeq()
+{
+	_result.events++;
+	Pop();
+}
+
+void Decoder::Key(std::string_view a_key)
+{
+	if (!_stack.empty())
+		_stack.back().key = a_key;
+}
+
+void Decoder::Scalar(std::string_view a_value)
+{
+	_result.events++;
+
+	if (_stack.empty())
+		return;
+
+	auto& top = _stack.back();
+	switch (top.frame) {
+	case Frame::Document:
+		if (top.key == "macro") {
+			_macros = true;
+			AddMacro(a_value);
+		} else {
+			SetField(_command, top.key, a_value);
+		}
+		break;
+	case Frame::Command:
+		SetField(_command, top.key, a_value);
+		break;
+	case Frame::Sub:
+		SetField(_sub, top.key, a_value);
+		break;
+	case Frame::Arg:
+		SetField(_arg, top.key, a_value);
+		break;
+	case Frame::Choices:
+		_spec.choices.emplace_back(a_value);
+		break;
+	case Frame::MacroList:
+		AddMacro(a_value);
+		break;
+	case Frame::MacroMap:
+		_result.macros.emplace_back(top.key, a_value);
+		break;
+	default:
+		break;
+	}
+
+	top.key.clear();
+}
+
+void Decoder::Push(Frame a_frame)
+{
+	_stack.push_back({ a_frame, {} });
+}
+
+void Decoder::Pop()
+{
+	_stack.pop_back();
+
+	// the finished container was the value of the enclosing key
+	if (!_stack.empty())
+		_stack.back().key.clear();
+}
+
+void Decoder::SetField(Command& a_command, std::string_view a_key, std::string_view a_value)
+{
+	if (a_key == "name") {
+		a_command.name = StringPool::Intern(a_value);
+	} else if (a_key == "help") {
+		a_command.help = StringPool::Intern(a_value);
+	} else if (a_key == "alias") {
+		a_command.alias = StringPool::Intern(a_value);
+	} else if (a_key == "script") {
+		a_command.script = StringPool::Intern(a_value);
+	}
+}
+
+void Decoder::SetField(SubCommand& a_sub, std::string_view a_key, std::string_view a_value)
+{
+	if (a_key == "name") {
+		a_sub.name = StringPool::Intern(a_value);
+	} else if (a_key == "help") {
+		a_sub.help = StringPool::Intern(a_value);
+	} else if (a_key == "alias") {
+		a_sub.alias = StringPool::Intern(a_value);
+	} else if (a_key == "func") {
+		a_sub.func = StringPool::Intern(a_value);
+	} else if (a_key == "close") {
+		a_sub.close = a_value == "true";
+	} else if (a_key == "pure") {
+		a_sub.pure = a_value == "true";
+	} else if (a_key == "cache") {
+		if (const auto ttl = ToNumber(a_value))
+			a_sub.ttl = static_cast<float>(*ttl);
+		else
+			Fail(std::format("{}: cache must be a number of seconds", a_sub.name));
+	}
+}
+
+void Decoder::SetField(Arg& a_arg, std::string_view a_key, std::string_view a_value)
+{
+	if (a_key == "name") {
+		a_arg.name = StringPool::Intern(a_value);
+	} else if (a_key == "help") {
+		a_arg.help = StringPool::Intern(a_value);
+	} else if (a_key == "default") {
+		a_arg.defaultVal = StringPool::Intern(a_value);
+	} else if (a_key == "alias") {
+		a_arg.alias = StringPool::Intern(a_value);
+	} else if (a_key == "selected") {
+		a_arg.selected = a_value == "true";
+	} else if (a_key == "flag") {
+		a_arg.flag = a_value == "true";
+	} else if (a_key == "required") {
+		a_arg.required = a_value == "true";
+	} else if (a_key == "type") {
+		// array arguments keep their element type, e.g. actor[] is an Object array of actor
+		a_arg.array = a_value.ends_with("[]");
+		if (a_arg.array)
+			a_value.remove_suffix(2);
+
+		a_arg.rawType = StringPool::Intern(a_value);
+		a_arg.type = magic_enum::enum_cast<Arg::Type>(a_arg.rawType, magic_enum::case_insensitive).value_or(Arg::Type::Object);
+	} else if (a_key == "min" || a_key == "max") {
+		const auto value = ToNumber(a_value);
+		if (!value)
+			Fail(std::format("{}: {} must be a number", a_arg.name, a_key));
+		(a_key == "min" ? _spec.min : _spec.max) = value;
+	} else if (a_key == "pattern") {
+		_spec.pattern = a_value;
+	} else if (a_key == "form_type") {
+		_spec.formType = a_value;
+	} else if (a_key == "choices") {
+		// a single choice may be written as a scalar
+		_spec.choices.emplace_back(a_value);
+	}
+}
+
+void Decoder::AddMacro(std::string_view a_def)
+{
+	// macro: name = "line; line" as a single scalar or a list of them
+	const auto eq = a_def.find('=');
+	if (eq == std::string_view::npos) {
+		_result.errors.push_back(std::format("invalid macro {} - expected name = body", a_def));
+		return;
+	}
+
+	const auto name = Trim(a_def.substr(0, eq));
+	auto body = Trim(a_def.substr(eq + 1));
+	if (body.size() >= 2 && body.front() == '"' && body.back() == '"')
+		body = body.substr(1, body.size() - 2);
+
+	_result.macros.emplace_back(name, body);
+}
+
+void Decoder::CheckCollisions()
+{
+	// lookups take the first match, so a later duplicate is unreachable rather than an error
+	const auto check = [this](auto& a_seen, std::string_view a_name, std::string_view a_owner) {
+		if (a_name.empty())
+			return;
+		if (const auto [it, inserted] = a_seen.emplace(a_name, a_owner); !inserted)
+			_result.collisions.push_back(std::format("{}: {} of {} is shadowed by {}", _command.name, a_name, a_owner, it->second));
+	};
+
+	std::unordered_map<std::string_view, std::string_view> subs;
+	for (const auto& sub : _command.subs) {
+		check(subs, sub.name, sub.name);
+		// an alias repeating its own name is redundant, not shadowed
+		if (sub.alias != sub.name)
+			check(subs, sub.alias, sub.name);
+
+		std::unordered_map<std::string_view, std::string_view> flags;
+		for (const auto& arg : sub.args) {
+			if (arg.positional)
+				continue;
+			check(flags, arg.name, arg.name);
+			if (arg.alias != arg.name)
+				check(flags, arg.alias, arg.name);
+		}
+	}
+}
+
+void Decoder::FinishCommand()
+{
+	if (_command.name.empty() || _command.script.empty())
+		Fail(std::format("command {} requires a name and a script", _command.name));
+
+	if (_failed) {
+		_result.errors.push_back(std::format("skipping command {}", _command.name));
+		return;
+	}
+
+	CheckCollisions();
+	_command.subs.shrink_to_fit();
+	_result.commands.push_back(std::move(_command));
+	_command = {};
+}
+
+void Decoder::FinishSub()
+{
+	if (_sub.name.empty() || _sub.func.empty()) {
+		Fail(std::format("subcommand {} requires a name and a func", _sub.name));
+		return;
+	}
+
+	_sub.args.shrink_to_fit();
+	_command.subs.push_back(std::move(_sub));
+}
+
+void Decoder::FinishArg()
+{
+	if (_arg.name.empty()) {
+		Fail(std::format("{}: argument requires a name", _sub.name));
+		return;
+	}
+
+	_arg.positional = !_arg.name.starts_with("-");
+
+	try {
+		_arg.validator = Validator::Compile(_spec, _arg.type == Arg::Type::Int || _arg.type == Arg::Type::Float);
+	} catch (std::exception& e) {
+		Fail(std::format("{}: invalid constraint due to {}", _arg.name, e.what()));
+		return;
+	}
+
+	_sub.args.push_back(_arg);
+}
+
+void Decoder::Fail(std::string a_error)
+{
+	_failed = true;
+	_result.errors.push_back(std::move(a_error));
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Command.h"
+
+namespace C3
+{
+	// streaming builder for command definitions, fed map/sequence/scalar events by a YAML or JSON parser
+	// a file may hold one command, a "commands:" list, several "---" documents or a top-level array
+	class Decoder
+	{
+	public:
+		struct Result
+		{
+			std::vector<Command> commands;
+			std::vector<std::pair<std::string, std::string>> macros;
+			std::vector<std::string> errors;
+			std::vector<std::string> collisions;
+			std::uint64_t elapsed = 0;  // ns spent parsing and building
+			std::size_t events = 0;
+		};
+
+		static Result DecodeFile(const std::filesystem::path& a_path);
+		static Result DecodeYaml(std::istream& a_stream);
+		static Result DecodeJson(std::istream& a_stream);
+
+		void StartMap();
+		void EndMap();
+		void StartSeq();
+		void EndSeq();
+		void Key(std::string_view a_key);
+		void Scalar(std::string_view a_value);
+		// rejects the command under construction, for input the events cannot express
+		void Fail(std::string a_error);
+
+		inline Result Take() { return std::move(_result); }
+	private:
+		enum class Frame : std::uint8_t
+		{
+			Document,
+			CommandList,
+			Command,
+			SubList,
+			Sub,
+			ArgList,
+			Arg,
+			Choices,
+			MacroList,
+			MacroMap,
+			Skip,
+		};
+
+		struct State
+		{
+			Frame frame;
+			std::string key;
+		};
+
+		void Push(Frame a_frame);
+		void Pop();
+
+		void SetField(Command& a_command, std::string_view a_key, std::string_view a_value);
+		void SetField(SubCommand& a_sub, std::string_view a_key, std::string_view a_value);
+		void SetField(Arg& a_arg, std::string_view a_key, std::string_view a_value);
+		void AddMacro(std::string_view a_def);
+
+		void CheckCollisions();
+		void FinishCommand();
+		void FinishSub();
+		void FinishArg();
+
+		std::vector<State> _stack;
+		Result _result;
+
+		// nesting is fixed, so only one of each is ever under construction
+		Command _command;
+		SubCommand _sub;
+		Arg _arg;
+		Validator::Spec _spec;
+		bool _failed = false;
+		bool _bundle = false;
+		bool _macros = false;
+	};
+}
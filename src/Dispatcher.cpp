@@ -0,0 +1,140 @@
+#include "Dispatcher.h"
+
+using namespace C3;
+
+const Dispatcher::Target& Dispatcher::Get(const Command& a_cmd, const SubCommand& a_sub)
+{
+	if (const auto target = std::atomic_ref{ a_sub.target }.load(std::memory_order_acquire))
+		return *target;
+
+	{
+		std::scoped_lock guard{ _lock };
+		if (const auto it = _targets.find(&a_sub); it != _targets.end())
+			return it->second;
+	}
+
+	// resolved outside the lock, a concurrent first lookup of the same sub keeps whichever lands first
+	auto target = Resolve(a_cmd, a_sub);
+
+	std::scoped_lock guard{ _lock };
+	const auto [it, inserted] = _targets.emplace(&a_sub, std::move(target));
+	if (inserted && !it->second.IsValid())
+		logger::error("{} {}: {}", a_cmd.name, a_sub.name, it->second.error);
+
+	std::atomic_ref{ a_sub.target }.store(&it->second, std::memory_order_release);
+	return it->second;
+}
+
+Dispatcher::Target Dispatcher::Resolve(const Command& a_cmd, const SubCommand& a_sub)
+{
+	Target target;
+	target.script = a_cmd.script;
+	target.func = a_sub.func;
+	target.types.resize(a_sub.args.size());
+	target.classes.resize(a_sub.args.size());
+
+	for (std::size_t i = 0; i < a_sub.args.size(); i++) {
+		const auto& arg = a_sub.args[i];
+		if (arg.type != Arg::Type::Object)
+			continue;
+
+		target.classes[i] = arg.rawType;
+
+		// the lookup loads the script if the VM has not yet, so a miss means it does not exist
+		target.types[i] = Script::GetType(arg.rawType);
+		if (!target.types[i]) {
+			target.error = std::format("unknown script type {} for {}", arg.rawType, arg.name);
+			return target;
+		}
+	}
+
+	const auto type = Script::GetType(a_cmd.script);
+	if (!type) {
+		target.error = std::format("script {} not found", a_cmd.script);
+		return target;
+	}
+
+	RE::BSTSmartPointer<RE::BSScript::IFunction> func;
+	const auto funcs = type->GetGlobalFuncIter();
+	for (std::uint32_t i = 0; funcs && i < type->GetNumGlobalFuncs(); i++) {
+		const auto& candidate = funcs[i].func;
+		// fixed strings are interned case insensitively, like papyrus identifiers
+		if (candidate && candidate->GetName() == target.func) {
+			func = candidate;
+			break;
+		}
+	}
+
+	if (!func) {
+		target.error = std::format("global function {} not found in {}", a_sub.func, a_cmd.script);
+		return target;
+	}
+
+	if (func->GetParamCount() != a_sub.args.size()) {
+		target.error = std::format("{} takes {} parameters but {} args are declared", a_sub.func, func->GetParamCount(), a_sub.args.size());
+		return target;
+	}
+
+	for (std::uint32_t i = 0; i < func->GetParamCount(); i++) {
+		RE::BSFixedString name;
+		RE::BSScript::TypeInfo param;
+		func->GetParam(i, name, param);
+
+		if (auto mismatch = Check(a_sub.args[i], target.types[i], param)) {
+			target.error = std::format("{} does not match parameter {}: {}", a_sub.args[i].name, name.c_str(), *mismatch);
+			return target;
+		}
+	}
+
+	return target;
+}
+
+std::optional<std::string> Dispatcher::Check(const Arg& a_arg, const Script::TypePtr& a_type, const RE::BSScript::TypeInfo& a_param)
+{
+	using RawType = RE::BSScript::TypeInfo::RawType;
+
+	// object types are ObjectTypeInfo addresses with the low bit set for arrays of them
+	const auto raw = static_cast<std::uintptr_t>(a_param.GetRawType());
+	const bool object = raw >= static_cast<std::uintptr_t>(RawType::kArraysEnd) || raw == static_cast<std::uintptr_t>(RawType::kObject) || raw == static_cast<std::uintptr_t>(RawType::kObjectArray);
+	const bool array = raw >= static_cast<std::uintptr_t>(RawType::kArraysEnd) ? (raw & 1) != 0 : raw >= static_cast<std::uintptr_t>(RawType::kNoneArray);
+
+	if (array != a_arg.array)
+		return array ? "expected an array" : "did not expect an array";
+
+	if (object) {
+		if (a_arg.type != Arg::Type::Object)
+			return std::format("expected an object, declared {}", a_arg.rawType);
+
+		// the value is passed as the declared type, which must be the parameter's type or derive from it
+		const auto paramType = raw >= static_cast<std::uintptr_t>(RawType::kArraysEnd) ? reinterpret_cast<RE::BSScript::ObjectTypeInfo*>(raw & ~static_cast<std::uintptr_t>(1)) : nullptr;
+		if (paramType && a_type && !Script::Inherits(a_type.get(), paramType))
+			return std::format("{} is not a {}", a_arg.rawType, paramType->GetName());
+
+		return std::nullopt;
+	}
+
+	const auto element = static_cast<RawType>(array ? raw - (static_cast<std::uintptr_t>(RawType::kNoneArray) - static_cast<std::uintptr_t>(RawType::kNone)) : raw);
+
+	RawType expected = RawType::kNone;
+	switch (a_arg.type) {
+	case Arg::Type::Int:
+		expected = RawType::kInt;
+		break;
+	case Arg::Type::Float:
+		expected = RawType::kFloat;
+		break;
+	case Arg::Type::Bool:
+		expected = RawType::kBool;
+		break;
+	case Arg::Type::String:
+		expected = RawType::kString;
+		break;
+	default:
+		return "expected a value, declared an object";
+	}
+
+	if (element != expected)
+		return std::format("declared {}", a_arg.rawType);
+
+	return std::nullopt;
+}
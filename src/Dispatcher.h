@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Command.h"
+#include "Script.h"
+
+namespace C3
+{
+	struct DispatchTarget
+	{
+		inline bool IsValid() const { return error.empty(); }
+
+		RE::BSFixedString script;
+		RE::BSFixedString func;
+		std::vector<Script::TypePtr> types;      // per arg, set for object args
+		std::vector<RE::BSFixedString> classes;  // per arg, the bound script looked up on each form
+		std::string error;
+	};
+
+	// papyrus targets resolved once per subcommand, resolving calls into the VM so it belongs on the main thread
+	class Dispatcher
+	{
+	public:
+		using Target = DispatchTarget;
+
+		// every outcome is cached and never erased, the reference stays valid for the life of the plugin
+		// once resolved the target is published on the subcommand, so dispatching it again takes no lock
+		static const Target& Get(const Command& a_cmd, const SubCommand& a_sub);
+	private:
+		static Target Resolve(const Command& a_cmd, const SubCommand& a_sub);
+		static std::optional<std::string> Check(const Arg& a_arg, const Script::TypePtr& a_type, const RE::BSScript::TypeInfo& a_param);
+
+		// keyed by address, subcommands never move once their command is decoded
+		static inline std::mutex _lock;
+		static inline std::unordered_map<const SubCommand*, Target> _targets;
+	};
+}
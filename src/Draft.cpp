@@ -0,0 +1,49 @@
+#include "Draft.h"
+
+using namespace C3;
+
+bool Draft::Update(std::string_view a_line, bool a_hasRef)
+{
+	if (Matches(a_line, a_hasRef))
+		return false;
+
+	const auto common = static_cast<std::size_t>(std::ranges::mismatch(a_line, _line).in1 - a_line.begin());
+
+	// a token ending before the first edit cannot have changed, the character after it is a separator or past a closing quote
+	std::size_t kept = 0;
+	while (kept < _ends.size() && _ends[kept] < common) {
+		kept++;
+	}
+
+	std::vector<std::string> previous{ std::make_move_iterator(_tokens.begin() + kept), std::make_move_iterator(_tokens.end()) };
+	std::vector<bool> previousQuoted{ _quoted.begin() + kept, _quoted.end() };
+	_tokens.resize(kept);
+	_ends.resize(kept);
+	_quoted.resize(kept);
+
+	std::string token;
+	bool quoted = false;
+	for (auto pos = kept ? _ends.back() : 0; (pos = Parser::Scan(a_line, pos, token, quoted)) != std::string_view::npos;) {
+		_tokens.push_back(std::move(token));
+		_ends.push_back(pos);
+		_quoted.push_back(quoted);
+	}
+
+	const bool changed = a_hasRef != _hasRef || !std::ranges::equal(previous, std::span{ _tokens }.subspan(kept)) || !std::ranges::equal(previousQuoted, std::views::drop(_quoted, kept));
+
+	_line = a_line;
+	_hasRef = a_hasRef;
+	return changed;
+}
+
+void Draft::Clear()
+{
+	_line.clear();
+	_tokens.clear();
+	_ends.clear();
+	_quoted.clear();
+	_hasRef = false;
+	invocation.reset();
+	status.clear();
+	bind = 0;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Parser.h"
+
+namespace C3
+{
+	// the console line as it is being typed, tokens before the first edited character are kept between keystrokes
+	// tokenizes exactly like Parser::Tokenize so a drafted line can be submitted without tokenizing it again
+	class Draft
+	{
+	public:
+		// false when neither the tokens nor the selection changed, e.g. for trailing whitespace
+		bool Update(std::string_view a_line, bool a_hasRef);
+		void Clear();
+
+		inline bool Matches(std::string_view a_line, bool a_hasRef) const { return _line == a_line && _hasRef == a_hasRef; }
+		inline const std::vector<std::string>& GetTokens() const { return _tokens; }
+
+		// bound by the registry after each change, empty unless the line names one of our commands
+		std::optional<Invocation> invocation;
+		std::string status;
+		std::uint64_t bind = 0;  // ns spent binding, traced when the invocation is submitted
+	private:
+		std::string _line;
+		std::vector<std::string> _tokens;
+		std::vector<std::size_t> _ends;
+		std::vector<bool> _quoted;  // "> x" and ">x" redirect, the same tokens quoted do not
+		bool _hasRef = false;
+	};
+}
@@ -0,0 +1,203 @@
+#include "FormIndex.h"
+#include "Util.h"
+
+using namespace C3;
+
+namespace
+{
+	inline char Fold(char a_char) { return static_cast<char>(std::tolower(static_cast<unsigned char>(a_char))); }
+
+	inline bool LessInsensitive(std::string_view a_lhs, std::string_view a_rhs)
+	{
+		return std::lexicographical_compare(a_lhs.begin(), a_lhs.end(), a_rhs.begin(), a_rhs.end(),
+			[](char a, char b) { return Fold(a) < Fold(b); });
+	}
+
+	inline bool EqualsInsensitive(std::string_view a_lhs, std::string_view a_rhs)
+	{
+		return a_lhs.size() == a_rhs.size() && std::equal(a_lhs.begin(), a_lhs.end(), a_rhs.begin(),
+			[](char a, char b) { return Fold(a) == Fold(b); });
+	}
+}
+
+void FormIndex::Build()
+{
+	if (_ready || _building.exchange(true))
+		return;
+
+	std::thread(BuildImpl).detach();
+}
+
+void FormIndex::BuildImpl()
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	std::string names;
+	std::vector<Record> records;
+	std::unordered_set<RE::FormID> seen;
+
+	const auto add = [&](RE::FormID a_formID, std::string_view a_editorID) {
+		if (a_editorID.empty() || !seen.insert(a_formID).second)
+			return;
+
+		records.push_back({ static_cast<std::uint32_t>(names.size()), static_cast<std::uint32_t>(a_editorID.size()), a_formID });
+		names += a_editorID;
+	};
+
+	{
+		const auto& [map, lock] = RE::TESForm::GetAllFormsByEditorID();
+		const RE::BSReadLockGuard guard{ lock };
+		if (map) {
+			records.reserve(map->size());
+			for (const auto& [editorID, form] : *map) {
+				if (form)
+					add(form->GetFormID(), editorID.c_str());
+			}
+		}
+	}
+
+	// most form types drop their editor ID at load, po3_Tweaks keeps them around for us
+	// the global form lock is only held to collect ids, the main thread needs it to write while a save loads
+	std::vector<RE::FormID> missing;
+	{
+		const auto& [map, lock] = RE::TESForm::GetAllForms();
+		const RE::BSReadLockGuard guard{ lock };
+		if (map) {
+			missing.reserve(map->size());
+			for (const auto& [formID, form] : *map) {
+				if (!form || seen.contains(formID))
+					continue;
+
+				if (const auto editorID = form->GetFormEditorID(); editorID && *editorID)
+					add(formID, editorID);
+				else
+					missing.push_back(formID);
+			}
+		}
+	}
+
+	for (const auto formID : missing) {
+		add(formID, Util::GetTweaksEditorID(formID));
+	}
+
+	_names = std::move(names);
+	_byName = records;
+	_byID = std::move(records);
+
+	std::sort(_byName.begin(), _byName.end(), [](const Record& a, const Record& b) { return LessInsensitive(Name(a), Name(b)); });
+	std::sort(_byID.begin(), _byID.end(), [](const Record& a, const Record& b) { return a.formID < b.formID; });
+
+	// first record for each leading character so prefix searches start in the right bucket
+	std::size_t index = 0;
+	for (std::size_t c = 0; c < 256; c++) {
+		while (index < _byName.size() && static_cast<unsigned char>(Fold(Name(_byName[index]).front())) < c)
+			index++;
+		_buckets[c] = static_cast<std::uint32_t>(index);
+	}
+	_buckets[256] = static_cast<std::uint32_t>(_byName.size());
+
+	_ready.store(true, std::memory_order_release);
+
+	const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+	logger::info("indexed {} editor IDs ({} bytes) in {} ms", _byName.size(), _names.size(), elapsed.count());
+}
+
+std::string_view FormIndex::GetEditorID(RE::FormID a_formID)
+{
+	if (!IsReady())
+		return {};
+
+	auto it = std::lower_bound(_byID.begin(), _byID.end(), a_formID, [](const Record& a, RE::FormID b) { return a.formID < b; });
+	return it != _byID.end() && it->formID == a_formID ? Name(*it) : std::string_view{};
+}
+
+RE::TESForm* FormIndex::Find(std::string_view a_editorID)
+{
+	if (!IsReady() || a_editorID.empty())
+		return nullptr;
+
+	const auto [first, last] = PrefixRange(a_editorID);
+	for (auto i = first; i < last; i++) {
+		if (EqualsInsensitive(Name(_byName[i]), a_editorID))
+			return RE::TESForm::LookupByID(_byName[i].formID);
+	}
+
+	return nullptr;
+}
+
+std::vector<RE::TESForm*> FormIndex::Match(std::string_view a_pattern, std::size_t a_max)
+{
+	std::vector<RE::TESForm*> forms;
+
+	if (!IsPattern(a_pattern)) {
+		if (auto form = IsReady() ? Find(a_pattern) : RE::TESForm::LookupByEditorID(a_pattern))
+			forms.push_back(form);
+		return forms;
+	}
+
+	if (!IsReady()) {
+		logger::warn("form index is still building - cannot expand {}", a_pattern);
+		return forms;
+	}
+
+	const auto prefix = a_pattern.substr(0, a_pattern.find_first_of("*?"));
+	const auto [first, last] = PrefixRange(prefix);
+
+	for (auto i = first; i < last && forms.size() < a_max; i++) {
+		if (!Glob(a_pattern, Name(_byName[i])))
+			continue;
+
+		if (auto form = RE::TESForm::LookupByID(_byName[i].formID))
+			forms.push_back(form);
+	}
+
+	if (forms.size() >= a_max)
+		logger::warn("{} hit the cap of {} matches", a_pattern, a_max);
+
+	return forms;
+}
+
+std::pair<std::size_t, std::size_t> FormIndex::PrefixRange(std::string_view a_prefix)
+{
+	if (a_prefix.empty())
+		return { 0, _byName.size() };
+
+	const auto c = static_cast<unsigned char>(Fold(a_prefix.front()));
+	const auto begin = _byName.begin() + _buckets[c];
+	const auto end = _byName.begin() + _buckets[c + 1];
+
+	const auto first = std::lower_bound(begin, end, a_prefix, [](const Record& a, std::string_view b) { return LessInsensitive(Name(a), b); });
+	const auto last = std::upper_bound(first, end, a_prefix, [](std::string_view a, const Record& b) {
+		return LessInsensitive(a, Name(b).substr(0, a.size()));
+	});
+
+	return { static_cast<std::size_t>(first - _byName.begin()), static_cast<std::size_t>(last - _byName.begin()) };
+}
+
+bool FormIndex::Glob(std::string_view a_pattern, std::string_view a_str)
+{
+	std::size_t p = 0;
+	std::size_t s = 0;
+	std::size_t star = std::string_view::npos;
+	std::size_t mark = 0;
+
+	while (s < a_str.size()) {
+		if (p < a_pattern.size() && (a_pattern[p] == '?' || Fold(a_pattern[p]) == Fold(a_str[s]))) {
+			p++;
+			s++;
+		} else if (p < a_pattern.size() && a_pattern[p] == '*') {
+			star = p++;
+			mark = s;
+		} else if (star != std::string_view::npos) {
+			p = star + 1;
+			s = ++mark;
+		} else {
+			return false;
+		}
+	}
+
+	while (p < a_pattern.size() && a_pattern[p] == '*')
+		p++;
+
+	return p == a_pattern.size();
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace C3
+{
+	// sorted editor ID table built in the background after data load
+	// lookups fall back to the engine and po3_Tweaks until it is ready
+	class FormIndex
+	{
+	public:
+		static constexpr std::size_t MaxMatches = 512;
+
+		static void Build();
+		static inline bool IsReady() { return _ready.load(std::memory_order_acquire); }
+		static inline bool IsPattern(std::string_view a_str) { return a_str.find_first_of("*?") != std::string_view::npos; }
+
+		static std::string_view GetEditorID(RE::FormID a_formID);
+		static RE::TESForm* Find(std::string_view a_editorID);
+		static std::vector<RE::TESForm*> Match(std::string_view a_pattern, std::size_t a_max = MaxMatches);
+	private:
+		struct Record
+		{
+			std::uint32_t offset;
+			std::uint32_t length;
+			RE::FormID formID;
+		};
+
+		static void BuildImpl();
+		static bool Glob(std::string_view a_pattern, std::string_view a_str);
+		static std::pair<std::size_t, std::size_t> PrefixRange(std::string_view a_prefix);
+		static inline std::string_view Name(const Record& a_record) { return { _names.data() + a_record.offset, a_record.length }; }
+
+		static inline std::atomic_bool _ready = false;
+		static inline std::atomic_bool _building = false;
+		static inline std::string _names;
+		static inline std::vector<Record> _byName;
+		static inline std::vector<Record> _byID;
+		static inline std::array<std::uint32_t, 257> _buckets{};
+	};
+}
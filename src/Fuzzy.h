@@ -0,0 +1,145 @@
+#pragma once
+
+namespace C3::Fuzzy
+{
+	inline char Fold(char a_char) { return static_cast<char>(std::tolower(static_cast<unsigned char>(a_char))); }
+
+	// bounded, case-insensitive Levenshtein distance using Myers' bit-parallel algorithm
+	// the pattern is preprocessed once so many candidates can be checked against it cheaply
+	class Matcher
+	{
+	public:
+		static constexpr std::size_t MaxLength = 64;
+
+		explicit Matcher(std::string_view a_pattern) :
+			_length(std::min(a_pattern.size(), MaxLength))
+		{
+			for (std::size_t i = 0; i < _length; i++) {
+				_peq[static_cast<unsigned char>(Fold(a_pattern[i]))] |= 1ull << i;
+			}
+		}
+
+		// returns a value greater than a_max as soon as the distance is known to exceed it
+		std::size_t Distance(std::string_view a_text, std::size_t a_max) const
+		{
+			const auto m = _length;
+			const auto n = a_text.size();
+
+			if (m == 0)
+				return n;
+
+			if ((n > m ? n - m : m - n) > a_max)
+				return a_max + 1;
+
+			const std::uint64_t last = 1ull << (m - 1);
+			std::uint64_t pv = m == 64 ? ~0ull : (1ull << m) - 1;
+			std::uint64_t mv = 0;
+			std::size_t score = m;
+
+			for (std::size_t j = 0; j < n; j++) {
+				const auto eq = _peq[static_cast<unsigned char>(Fold(a_text[j]))];
+				const auto xv = eq | mv;
+				const auto xh = (((eq & pv) + pv) ^ pv) | eq;
+
+				auto ph = mv | ~(xh | pv);
+				auto mh = pv & xh;
+
+				if (ph & last)
+					score++;
+				else if (mh & last)
+					score--;
+
+				// every remaining column can lower the score by at most one
+				if (score > a_max + (n - j - 1))
+					return a_max + 1;
+
+				ph = (ph << 1) | 1;
+				mh <<= 1;
+				pv = mh | ~(xv | ph);
+				mv = ph & xv;
+			}
+
+			return score;
+		}
+
+	private:
+		std::array<std::uint64_t, 256> _peq{};
+		std::size_t _length;
+	};
+
+	inline std::size_t Threshold(std::string_view a_query) { return std::clamp<std::size_t>(a_query.size() / 3, 1, 3); }
+
+	// closest candidates within the distance threshold for a_query, best first
+	template <class Range>
+	std::vector<std::string_view> Suggest(std::string_view a_query, const Range& a_candidates, std::size_t a_count = 3)
+	{
+		const Matcher matcher{ a_query };
+		const auto max = Threshold(a_query);
+
+		std::vector<std::pair<std::size_t, std::string_view>> scored;
+		for (std::string_view candidate : a_candidates) {
+			if (candidate.empty())
+				continue;
+
+			if (const auto distance = matcher.Distance(candidate, max); distance <= max)
+				scored.emplace_back(distance, candidate);
+		}
+
+		std::stable_sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+		std::vector<std::string_view> result;
+		for (const auto& [distance, candidate] : scored) {
+			if (result.size() >= a_count)
+				break;
+			if (std::find(result.begin(), result.end(), candidate) == result.end())
+				result.push_back(candidate);
+		}
+		return result;
+	}
+
+	inline std::string Join(const std::vector<std::string_view>& a_names)
+	{
+		std::string msg;
+		for (const auto name : a_names) {
+			if (!msg.empty())
+				msg += ", ";
+			msg += name;
+		}
+		return msg;
+	}
+
+	// registry-wide name list kept sorted by length, so only names within the edit bound are scanned
+	class Index
+	{
+	public:
+		void Add(std::string_view a_name)
+		{
+			if (a_name.empty())
+				return;
+
+			_names.push_back(a_name);
+			_sorted = false;
+		}
+
+		std::vector<std::string_view> Suggest(std::string_view a_query, std::size_t a_count = 3)
+		{
+			if (!_sorted) {
+				std::stable_sort(_names.begin(), _names.end(), [](auto a, auto b) { return a.size() < b.size(); });
+				_sorted = true;
+			}
+
+			const auto max = Threshold(a_query);
+			const auto shortest = a_query.size() > max ? a_query.size() - max : 0;
+			const auto longest = a_query.size() + max;
+
+			const auto first = std::lower_bound(_names.begin(), _names.end(), shortest, [](std::string_view a, std::size_t b) { return a.size() < b; });
+			const auto last = std::upper_bound(first, _names.end(), longest, [](std::size_t a, std::string_view b) { return a < b.size(); });
+
+			return Fuzzy::Suggest(a_query, std::ranges::subrange(first, last), a_count);
+		}
+
+	private:
+		std::vector<std::string_view> _names;
+		bool _sorted = true;
+	};
+}
@@ -11,14 +11,61 @@ void Hooks::CompileAndRun(RE::Script* a_script, RE::ScriptCompiler* a_compiler,
 	_CompileAndRun(a_script, a_compiler, a_name, a_targetRef);
 }
 
+void Hooks::Update(RE::Main* a_main, float a_delta)
+{
+	_Update(a_main, a_delta);
+
+	// lines submitted from other threads are picked up once per frame
+	Commands::Drain();
+}
+
+void Hooks::AdvanceMovie(RE::Console* a_console, float a_interval, std::uint32_t a_currentTime)
+{
+	_AdvanceMovie(a_console, a_interval, a_currentTime);
+
+	const auto& movie = a_console->uiMovie;
+	if (!movie)
+		return;
+
+	// the movie has no edit callback, but reading the entry once a frame is cheap and Preview returns early when nothing changed
+	RE::GFxValue entry;
+	if (!movie->GetVariable(&entry, "_root.ConsoleFader_mc.Console_mc.CommandEntry.text") || !entry.IsString())
+		return;
+
+	const auto ref = RE::Console::GetSelectedRef();
+	const auto selected = ref ? ref->GetFormID() : 0;
+
+	const auto& status = Commands::Preview(entry.GetString(), static_cast<bool>(ref));
+	if (status == _status && selected == _selected)
+		return;
+
+	constexpr auto path = "_root.ConsoleFader_mc.Console_mc.CurrentSelection.text";
+
+	// picking a reference rewrites the line, replacing both the saved selection and any status shown over it
+	if (_status.empty() || selected != _selected) {
+		RE::GFxValue selection;
+		if (movie->GetVariable(&selection, path) && selection.IsString())
+			_selection = selection.GetString();
+	}
+
+	_selected = selected;
+	_status = status;
+	movie->SetVariable(path, RE::GFxValue{ _status.empty() ? _selection.c_str() : _status.c_str() });
+}
 
 void Hooks::Install()
 {
-	SKSE::AllocTrampoline(1 << 4);
+	SKSE::AllocTrampoline(1 << 5);
 
 	REL::Relocation<std::uintptr_t> hookPoint{ REL::RelocationID(52065, 52952), REL::VariantOffset(0xE2, 0x52, 0xE2) };
 	auto& trampoline = SKSE::GetTrampoline();
 	_CompileAndRun = trampoline.write_call<5>(hookPoint.address(), CompileAndRun);
 
+	REL::Relocation<std::uintptr_t> updatePoint{ REL::RelocationID(35565, 36564), REL::VariantOffset(0x748, 0xC26, 0x7EE) };
+	_Update = trampoline.write_call<5>(updatePoint.address(), Update);
+
+	REL::Relocation<std::uintptr_t> consoleVtbl{ RE::VTABLE_Console[0] };
+	_AdvanceMovie = consoleVtbl.write_vfunc(0x5, AdvanceMovie);
+
 	logger::info("Installed hooks");
 }
\ No newline at end of file
@@ -9,5 +9,16 @@ namespace C3
 	private:
 		static void CompileAndRun(RE::Script* a_script, RE::ScriptCompiler* a_compiler, RE::COMPILER_NAME a_name, RE::TESObjectREFR* a_targetRef);
 		inline static REL::Relocation<decltype(CompileAndRun)> _CompileAndRun;
+
+		static void Update(RE::Main* a_main, float a_delta);
+		inline static REL::Relocation<decltype(Update)> _Update;
+
+		static void AdvanceMovie(RE::Console* a_console, float a_interval, std::uint32_t a_currentTime);
+		inline static REL::Relocation<decltype(AdvanceMovie)> _AdvanceMovie;
+
+		// the console's selection line doubles as the status line while a typed command would be rejected
+		inline static std::string _status;
+		inline static std::string _selection;
+		inline static RE::FormID _selected = 0;
 	};
 }
\ No newline at end of file
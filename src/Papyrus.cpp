@@ -0,0 +1,18 @@
+#include "Papyrus.h"
+#include "Commands.h"
+
+using namespace C3;
+
+bool Papyrus::Register(RE::BSScript::IVirtualMachine* a_vm)
+{
+	a_vm->RegisterFunction("Execute", Script, Execute);
+
+	logger::info("registered papyrus functions");
+	return true;
+}
+
+bool Papyrus::Execute(RE::StaticFunctionTag*, std::string a_line, RE::TESObjectREFR* a_target)
+{
+	// output goes to the console as if the line had been typed
+	return Commands::Enqueue(std::move(a_line), a_target ? a_target->GetFormID() : 0, {});
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+namespace C3
+{
+	// natives bound to the CustomConsole script
+	class Papyrus
+	{
+	public:
+		static bool Register(RE::BSScript::IVirtualMachine* a_vm);
+	private:
+		static bool Execute(RE::StaticFunctionTag*, std::string a_line, RE::TESObjectREFR* a_target);
+
+		static constexpr std::string_view Script = "CustomConsole";
+	};
+}
@@ -0,0 +1,373 @@
+#include "Parser.h"
+#include "Fuzzy.h"
+
+using namespace C3;
+
+std::vector<std::string> Parser::Tokenize(std::string_view a_line)
+{
+	std::vector<std::string> tokens;
+	std::string token;
+	bool quoted = false;
+
+	for (std::size_t pos = 0; (pos = Scan(a_line, pos, token, quoted)) != std::string_view::npos;) {
+		tokens.push_back(std::move(token));
+	}
+
+	return tokens;
+}
+
+std::size_t Parser::Scan(std::string_view a_line, std::size_t a_pos, std::string& a_token, bool& a_quoted)
+{
+	const auto space = [&](std::size_t a_i) { return std::isspace(static_cast<unsigned char>(a_line[a_i])) != 0; };
+
+	while (a_pos < a_line.size() && space(a_pos)) {
+		a_pos++;
+	}
+
+	if (a_pos == a_line.size())
+		return std::string_view::npos;
+
+	a_token.clear();
+	a_quoted = a_line[a_pos] == '"';
+
+	if (!a_quoted) {
+		for (; a_pos < a_line.size() && !space(a_pos); a_pos++) {
+			a_token += a_line[a_pos];
+		}
+		return a_pos;
+	}
+
+	// a backslash escapes the next character and an unterminated quote is dropped
+	for (a_pos++; a_pos < a_line.size(); a_pos++) {
+		if (a_line[a_pos] == '"')
+			return a_pos + 1;
+
+		if (a_line[a_pos] == '\\' && ++a_pos == a_line.size())
+			break;
+
+		a_token += a_line[a_pos];
+	}
+
+	return std::string_view::npos;
+}
+
+std::string Parser::Join(const std::vector<std::string>& a_tokens)
+{
+	// the inverse of Tokenize, tokens that would split again are quoted
+	std::ostringstream oss;
+	for (std::size_t i = 0; i < a_tokens.size(); i++) {
+		if (i > 0)
+			oss << ' ';
+
+		const auto& token = a_tokens[i];
+		if (token.empty() || token.find_first_of(" \t\"\\") != std::string::npos)
+			oss << std::quoted(token);
+		else
+			oss << token;
+	}
+
+	return oss.str();
+}
+
+std::vector<std::string> Parser::SplitLines(std::string_view a_body)
+{
+	std::vector<std::string> lines;
+	std::string line;
+	bool quoted = false;
+
+	// semicolons inside quotes belong to the argument, not the macro
+	for (const auto c : a_body) {
+		if (c == '"')
+			quoted = !quoted;
+
+		if (c == ';' && !quoted) {
+			lines.push_back(std::move(line));
+			line.clear();
+		} else {
+			line += c;
+		}
+	}
+	lines.push_back(std::move(line));
+
+	std::erase_if(lines, [](const std::string& a_line) { return a_line.find_first_not_of(" \t") == std::string::npos; });
+	return lines;
+}
+
+std::vector<std::string> Parser::Substitute(const std::vector<std::string>& a_tokens, const std::vector<std::string>& a_args)
+{
+	std::vector<std::string> result;
+	result.reserve(a_tokens.size());
+
+	for (const auto& token : a_tokens) {
+		if (token == "$*") {
+			result.insert(result.end(), a_args.begin(), a_args.end());
+			continue;
+		}
+
+		// $1 to $9 may appear anywhere in a token, e.g. --count=$1
+		std::string substituted;
+		for (std::size_t i = 0; i < token.size(); i++) {
+			if (token[i] == '$' && i + 1 < token.size() && token[i + 1] >= '1' && token[i + 1] <= '9') {
+				const auto index = static_cast<std::size_t>(token[i + 1] - '1');
+				if (index < a_args.size())
+					substituted += a_args[index];
+				i++;
+			} else {
+				substituted += token[i];
+			}
+		}
+		result.push_back(std::move(substituted));
+	}
+
+	return result;
+}
+
+std::size_t Parser::CountParams(const std::vector<std::string>& a_tokens)
+{
+	std::size_t count = 0;
+	for (const auto& token : a_tokens) {
+		for (std::size_t i = 0; i + 1 < token.size(); i++) {
+			if (token[i] == '$' && token[i + 1] >= '1' && token[i + 1] <= '9')
+				count = std::max(count, static_cast<std::size_t>(token[i + 1] - '0'));
+		}
+	}
+	return count;
+}
+
+std::optional<Redirect> Parser::ExtractRedirect(std::vector<std::string>& a_tokens, std::string_view a_line)
+{
+	std::vector<bool> quoted;
+	std::string token;
+	bool isQuoted = false;
+	for (std::size_t pos = 0; (pos = Scan(a_line, pos, token, isQuoted)) != std::string_view::npos;) {
+		quoted.push_back(isQuoted);
+	}
+
+	const auto count = a_tokens.size();
+	if (quoted.size() != count)
+		return std::nullopt;
+
+	// only the end of the line may redirect, and a quoted token is always an argument
+	// ">file" as the last token
+	if (count >= 2 && !quoted[count - 1] && a_tokens[count - 1].starts_with('>')) {
+		Redirect redirect;
+		redirect.append = a_tokens[count - 1].starts_with(">>");
+		redirect.path = a_tokens[count - 1].substr(redirect.append ? 2 : 1);
+
+		if (!redirect.path.empty()) {
+			a_tokens.pop_back();
+			return redirect;
+		}
+	}
+
+	// "> file" as the last two, the path itself may be quoted
+	if (count >= 3 && !quoted[count - 2] && (a_tokens[count - 2] == ">" || a_tokens[count - 2] == ">>")) {
+		Redirect redirect;
+		redirect.append = a_tokens[count - 2] == ">>";
+		redirect.path = a_tokens[count - 1];
+
+		if (!redirect.path.empty()) {
+			a_tokens.resize(count - 2);
+			return redirect;
+		}
+	}
+
+	return std::nullopt;
+}
+
+Invocation Parser::Bind(const Command& a_cmd, const std::vector<std::string>& a_tokens, bool a_hasRef, bool a_quiet)
+{
+	Invocation invocation;
+	invocation.cmd = &a_cmd;
+
+	if (a_tokens.size() == 1 || a_tokens[1] == "-h" || a_tokens[1] == "--help") {
+		invocation.help = true;
+		return invocation;
+	}
+
+	const auto sub = a_cmd.GetSub(a_tokens[1]);
+	if (!sub) {
+		if (const auto suggestions = Fuzzy::Suggest(a_tokens[1], a_cmd.GetSubNames()); !suggestions.empty())
+			invocation.errors.push_back(std::format("invalid subcommand {} - did you mean {}?", a_tokens[1], Fuzzy::Join(suggestions)));
+		else
+			invocation.errors.push_back(std::format("invalid subcommand {}", a_tokens[1]));
+		return invocation;
+	}
+
+	if (!a_quiet)
+		logger::info("subcommand {} recognized", sub->name);
+	invocation.sub = sub;
+
+	std::vector<std::optional<std::string>> flags(sub->args.size());
+	std::vector<std::string> positional;
+	std::string unrecognized;
+	std::string invalid;
+
+	if (auto selected = sub->GetSelected()) {
+		if (a_hasRef) {
+			if (selected->positional)
+				positional.emplace_back("selected");
+			else
+				flags[sub->IndexOf(selected)] = "selected";
+		}
+	}
+
+	// TODO: add support for --flag=value pattern
+	for (std::size_t i = 2; i < a_tokens.size(); i++) {
+		const auto& token = a_tokens[i];
+
+		if (token == "-h" || token == "--help") {
+			invocation.help = true;
+			return invocation;
+		}
+
+		if (token.starts_with("-") && !IsNumeric(token)) {
+			if (auto arg = sub->GetFlag(token)) {
+				if (arg->flag) {
+					flags[sub->IndexOf(arg)] = "true";
+				} else if ((i + 1) < a_tokens.size() && (!a_tokens[i + 1].starts_with("-") || IsNumeric(a_tokens[i + 1]))) {
+					flags[sub->IndexOf(arg)] = a_tokens[i + 1];
+					if (!a_quiet)
+						logger::info("adding {} to flags", a_tokens[i + 1]);
+					i++;
+				} else {
+					invalid += arg->name;
+					invalid += " ";
+				}
+			} else {
+				unrecognized += token;
+				if (const auto suggestions = Fuzzy::Suggest(token, sub->GetFlagNames()); !suggestions.empty())
+					unrecognized += std::format(" (did you mean {}?)", Fuzzy::Join(suggestions));
+				unrecognized += " ";
+			}
+		} else {
+			if (!a_quiet)
+				logger::info("adding {} to positional", token);
+			positional.push_back(token);
+		}
+	}
+
+	if (!unrecognized.empty()) {
+		invocation.errors.push_back(std::format("unrecognized flag arguments: {}", unrecognized));
+	}
+
+	if (!invalid.empty()) {
+		invocation.errors.push_back(std::format("invalid flag arguments - was expecting value for: {}", invalid));
+	}
+
+	if (!invocation.errors.empty()) {
+		return invocation;
+	}
+
+	invocation.values.resize(sub->args.size());
+
+	std::string missing;
+	std::vector<bool> supplied(sub->args.size());
+
+	std::size_t pos = 0;
+	for (std::size_t index = 0; index < sub->args.size(); index++) {
+		const auto& arg = sub->args[index];
+		auto& value = invocation.values[index];
+
+		if (arg.positional && pos < positional.size()) {
+			value = std::move(positional[pos]);
+			if (!a_quiet)
+				logger::info("setting {} to {}", index, value);
+			supplied[index] = true;
+			pos++;
+		} else if (!arg.positional && flags[index]) {
+			value = std::move(*flags[index]);
+			if (!a_quiet)
+				logger::info("setting {} to {}", index, value);
+			supplied[index] = true;
+		} else if (!arg.required) {
+			value = GetDefault(arg);
+			if (!a_quiet)
+				logger::info("setting {} to {}", index, value);
+		} else {
+			if (!a_quiet)
+				logger::info("{} is missing", index);
+			missing += arg.name;
+			missing += " ";
+		}
+	}
+
+	if (!missing.empty()) {
+		invocation.errors.push_back(std::format("missing arguments {}", missing));
+		return invocation;
+	}
+
+	// defaults come from the definition itself, only what the user typed is checked
+	for (std::size_t index = 0; index < sub->args.size(); index++) {
+		if (!supplied[index])
+			continue;
+
+		if (auto error = Validate(sub->args[index], invocation.values[index]))
+			invocation.errors.push_back(std::format("{}: {}", sub->args[index].name, *error));
+	}
+
+	return invocation;
+}
+
+bool Parser::IsNumeric(std::string_view a_str)
+{
+	static const std::regex pattern(R"(^[+-]?(?:\d+|\d*\.\d+)$)");
+	return std::regex_match(a_str.begin(), a_str.end(), pattern);
+}
+
+std::optional<std::string> Parser::Validate(const Arg& a_arg, std::string_view a_value)
+{
+	if (a_value == "none" || a_value == "selected")
+		return std::nullopt;
+
+	const auto check = [&a_arg](std::string_view a_element) -> std::optional<std::string> {
+		switch (a_arg.type) {
+		case Arg::Type::Int:
+			if (!ToNumber<std::int32_t>(a_element))
+				return std::format("'{}' is not an int", a_element);
+			break;
+		case Arg::Type::Float:
+			if (!ToNumber<float>(a_element))
+				return std::format("'{}' is not a float", a_element);
+			break;
+		case Arg::Type::Bool:
+			if (a_element != "true" && a_element != "false" && a_element != "TRUE" && a_element != "FALSE" && a_element != "1" && a_element != "0")
+				return std::format("'{}' is not a bool", a_element);
+			break;
+		default:
+			break;
+		}
+
+		return a_arg.validator ? a_arg.validator->Check(a_element) : std::nullopt;
+	};
+
+	if (!a_arg.array)
+		return check(a_value);
+
+	for (const auto element : std::views::split(a_value, ',')) {
+		if (auto error = check(std::string_view{ element.begin(), element.end() }))
+			return error;
+	}
+
+	return std::nullopt;
+}
+
+std::string Parser::GetDefault(const Arg& a_arg)
+{
+	if (!a_arg.defaultVal.empty())
+		return std::string{ a_arg.defaultVal };
+
+	switch (a_arg.type) {
+	case Arg::Type::Int:
+		return "0";
+	case Arg::Type::Bool:
+		return "false";
+	case Arg::Type::Float:
+		return "0.0";
+	case Arg::Type::String:
+		return "";
+	case Arg::Type::Object:
+	default: 
+		return "none";
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Command.h"
+
+namespace C3
+{
+	// output redirection parsed from a trailing "> file" or ">> file"
+	struct Redirect
+	{
+		std::string path;
+		bool append = false;
+	};
+
+	// receives the output of a submitted line instead of the console, success is false for errors
+	using Reply = std::function<void(std::string_view a_result, bool a_success)>;
+
+	// a command line bound against its definition, independent of the game
+	struct Invocation
+	{
+		inline bool IsValid() const { return cmd && sub && errors.empty(); }
+
+		const Command* cmd = nullptr;
+		const SubCommand* sub = nullptr;
+		std::vector<std::string> values;
+		std::vector<std::string> errors;
+		std::optional<Redirect> redirect;
+		Reply reply;
+		bool help = false;
+	};
+
+	class Parser
+	{
+	public:
+		static std::vector<std::string> Tokenize(std::string_view a_line);
+		// scans one token from a_pos with std::quoted's rules, returns the offset past it or npos at the end of the line
+		static std::size_t Scan(std::string_view a_line, std::size_t a_pos, std::string& a_token, bool& a_quoted);
+		static std::string Join(const std::vector<std::string>& a_tokens);
+		static std::vector<std::string> SplitLines(std::string_view a_body);
+		static std::vector<std::string> Substitute(const std::vector<std::string>& a_tokens, const std::vector<std::string>& a_args);
+		static std::size_t CountParams(const std::vector<std::string>& a_tokens);
+		// a_tokens must be the tokens of a_line, which tells quoted arguments apart from a redirect
+		static std::optional<Redirect> ExtractRedirect(std::vector<std::string>& a_tokens, std::string_view a_line);
+		// a_quiet skips the per-token logging, for previews that rebind the line on every keystroke
+		static Invocation Bind(const Command& a_cmd, const std::vector<std::string>& a_tokens, bool a_hasRef, bool a_quiet);
+
+		static bool IsNumeric(std::string_view a_str);
+
+		// shared by validation and dispatch so both accept the same numbers, a leading + included
+		template <class T>
+		static std::optional<T> ToNumber(std::string_view a_str)
+		{
+			if (a_str.starts_with('+'))
+				a_str.remove_prefix(1);
+
+			T value{};
+			const auto last = a_str.data() + a_str.size();
+			if (const auto [ptr, ec] = std::from_chars(a_str.data(), last, value); ec != std::errc{} || ptr != last)
+				return std::nullopt;
+			return value;
+		}
+		static std::optional<std::string> Validate(const Arg& a_arg, std::string_view a_value);
+		static std::string GetDefault(const Arg& a_arg);
+	};
+}
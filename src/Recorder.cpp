@@ -0,0 +1,61 @@
+#include "Recorder.h"
+#include "Writer.h"
+
+using namespace C3;
+
+void Recorder::Start(std::string_view a_file)
+{
+	std::unique_lock lock{ _lock };
+
+	_file = a_file;
+	_origin = Clock::now();
+	_count = 0;
+
+	// the header truncates any previous trace of the same name, records are appended behind it
+	Writer::Write(_file, Trace::EncodeHeader(), false);
+	_recording = true;
+
+	logger::info("recording commands to {}", _file);
+}
+
+void Recorder::Stop()
+{
+	std::unique_lock lock{ _lock };
+
+	if (!_recording)
+		return;
+
+	_recording = false;
+	logger::info("stopped recording to {} after {} records", _file, _count);
+}
+
+std::optional<Trace::Record> Recorder::Begin(std::string_view a_line, std::uint32_t a_ref)
+{
+	if (!IsRecording())
+		return std::nullopt;
+
+	Trace::Record record;
+	record.line = a_line;
+	record.ref = a_ref;
+
+	std::unique_lock lock{ _lock };
+	record.time = Elapsed(_origin);
+	return record;
+}
+
+void Recorder::Finish(Trace::Record a_record, std::string_view a_result, Trace::Status a_status)
+{
+	std::unique_lock lock{ _lock };
+
+	if (!_recording)
+		return;
+
+	// records begun before a restart belong to the old session's clock
+	const auto now = Elapsed(_origin);
+	a_record.total = now > a_record.time ? now - a_record.time : 0;
+	a_record.result = a_result;
+	a_record.status = a_status;
+
+	Writer::Write(_file, Trace::Encode(a_record), true);
+	_count++;
+}
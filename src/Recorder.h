@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Trace.h"
+
+namespace C3
+{
+	// captures handled commands into a trace in the log directory while a session is being recorded
+	class Recorder
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		static void Start(std::string_view a_file);
+		static void Stop();
+		static inline bool IsRecording() { return _recording.load(std::memory_order_relaxed); }
+
+		// nullopt when not recording, so callers pay nothing outside a session
+		static std::optional<Trace::Record> Begin(std::string_view a_line, std::uint32_t a_ref);
+		static void Finish(Trace::Record a_record, std::string_view a_result, Trace::Status a_status);
+
+		static inline std::uint64_t Elapsed(Clock::time_point a_since)
+		{
+			return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - a_since).count());
+		}
+	private:
+		static inline std::mutex _lock;
+		static inline std::atomic<bool> _recording = false;
+		static inline std::string _file;
+		static inline Clock::time_point _origin;
+		static inline std::size_t _count = 0;
+	};
+}
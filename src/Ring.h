@@ -0,0 +1,81 @@
+#pragma once
+
+// the slots and indices are padded to cache lines on purpose, which MSVC reports as C4324
+#pragma warning(push)
+#pragma warning(disable: 4324)
+
+namespace C3
+{
+	// bounded multi-producer single-consumer queue after Vyukov's bounded MPMC queue
+	// producers claim a slot with one CAS on the tail and never block, the slot's sequence hands it over to the consumer
+	template <class T, std::size_t Capacity>
+	class Ring
+	{
+		static_assert(std::has_single_bit(Capacity), "capacity must be a power of two");
+
+	public:
+		Ring() :
+			_slots(std::make_unique<Slot[]>(Capacity))
+		{
+			for (std::size_t i = 0; i < Capacity; i++) {
+				_slots[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		// false when the ring is full, the value is left untouched so the caller may retry
+		bool TryPush(T& a_value)
+		{
+			auto pos = _tail.load(std::memory_order_relaxed);
+
+			while (true) {
+				auto& slot = _slots[pos & Mask];
+				const auto sequence = slot.sequence.load(std::memory_order_acquire);
+				const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+
+				if (diff == 0) {
+					if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						slot.value = std::move(a_value);
+						slot.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				} else if (diff < 0) {
+					return false;
+				} else {
+					pos = _tail.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		// consumer only
+		std::optional<T> TryPop()
+		{
+			auto& slot = _slots[_head & Mask];
+			const auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+			if (static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(_head + 1) < 0)
+				return std::nullopt;
+
+			std::optional<T> value{ std::move(slot.value) };
+			slot.value = T{};
+			slot.sequence.store(_head + Capacity, std::memory_order_release);
+			_head++;
+
+			return value;
+		}
+
+	private:
+		static constexpr std::size_t Mask = Capacity - 1;
+
+		struct alignas(64) Slot
+		{
+			std::atomic<std::size_t> sequence;
+			T value;
+		};
+
+		std::unique_ptr<Slot[]> _slots;
+		alignas(64) std::atomic<std::size_t> _tail = 0;
+		alignas(64) std::size_t _head = 0;
+	};
+}
+
+#pragma warning(pop)
@@ -17,18 +17,68 @@ namespace C3::Script
 	}
 	
 
-	inline ObjectPtr GetObjectPtr(RE::TESForm* a_form, const char* a_class)
+	// class names are interned once, by the dispatch target or a static, instead of on every lookup
+	inline ObjectPtr GetObjectPtr(RE::TESForm* a_form, const RE::BSFixedString& a_class)
 	{
 		auto vm = InternalVM::GetSingleton();
 		auto handle = GetHandle(a_form);
 
 		ObjectPtr object = nullptr;
 		
-		vm->FindBoundObject(handle, a_class, object);
+		vm->FindBoundObject(handle, a_class.c_str(), object);
 
 		return object;
 	}
 
+	// forms without the declared script are still passed, bound as form
+	inline ObjectPtr GetBoundObject(RE::TESForm* a_form, const RE::BSFixedString& a_class)
+	{
+		if (auto object = GetObjectPtr(a_form, a_class))
+			return object;
+
+		// interned on first use, the string cache is not up yet while statics initialize
+		static const RE::BSFixedString form{ "form" };
+		return GetObjectPtr(a_form, form);
+	}
+
+	// the raw type of an object variable is the address of its ObjectTypeInfo
+	inline RE::BSScript::TypeInfo::RawType GetRawType(const RE::BSScript::ObjectTypeInfo* a_type)
+	{
+		return static_cast<RE::BSScript::TypeInfo::RawType>(reinterpret_cast<std::uintptr_t>(a_type));
+	}
+
+	// linked script types live as long as the VM, so each is looked up once per name
+	inline TypePtr GetType(std::string_view a_class)
+	{
+		static std::mutex lock;
+		static std::unordered_map<std::string, TypePtr> types;
+
+		std::string key{ a_class };
+		std::transform(key.begin(), key.end(), key.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+
+		std::unique_lock guard{ lock };
+		if (const auto it = types.find(key); it != types.end())
+			return it->second;
+
+		TypePtr type;
+		auto vm = InternalVM::GetSingleton();
+		if (!vm || !vm->GetScriptObjectType1(key.c_str(), type) || !type)
+			return nullptr;
+
+		types.emplace(std::move(key), type);
+		return type;
+	}
+
+	inline bool Inherits(RE::BSScript::ObjectTypeInfo* a_type, const RE::BSScript::ObjectTypeInfo* a_base)
+	{
+		for (auto type = a_type; type; type = type->GetParent()) {
+			if (type == a_base)
+				return true;
+		}
+
+		return false;
+	}
+
 	template <class T>
 	inline T GetProperty(ObjectPtr a_obj, RE::BSFixedString a_prop)
 	{
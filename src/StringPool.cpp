@@ -0,0 +1,41 @@
+#include "StringPool.h"
+
+using namespace C3;
+
+std::string_view StringPool::Intern(std::string_view a_str)
+{
+	if (a_str.empty())
+		return {};
+
+	std::unique_lock lock{ _lock };
+
+	if (auto it = _strings.find(a_str); it != _strings.end())
+		return *it;
+
+	auto dest = Allocate(a_str.size() + 1);
+	std::memcpy(dest, a_str.data(), a_str.size());
+	dest[a_str.size()] = '\0';
+
+	std::string_view interned{ dest, a_str.size() };
+	_strings.insert(interned);
+	return interned;
+}
+
+char* StringPool::Allocate(std::size_t a_size)
+{
+	if (a_size > BlockSize / 4) {
+		// oversized strings get a dedicated block so the current one keeps filling
+		_bytes += a_size;
+		return _blocks.insert(_blocks.end() - (_blocks.empty() ? 0 : 1), std::make_unique<char[]>(a_size))->get();
+	}
+
+	if (_used + a_size > BlockSize) {
+		_blocks.emplace_back(std::make_unique<char[]>(BlockSize));
+		_bytes += BlockSize;
+		_used = 0;
+	}
+
+	auto dest = _blocks.back().get() + _used;
+	_used += a_size;
+	return dest;
+}
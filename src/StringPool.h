@@ -0,0 +1,33 @@
+#pragma once
+
+namespace C3
+{
+	// append-only arena backing every name, alias, type and help string in the registry
+	// interned views stay valid for the lifetime of the plugin and are always null-terminated
+	class StringPool
+	{
+	public:
+		static std::string_view Intern(std::string_view a_str);
+		static inline std::size_t GetBytes() { return _bytes; }
+		static inline std::size_t GetCount()
+		{
+			std::unique_lock lock{ _lock };
+			return _strings.size();
+		}
+		static inline float GetLoadFactor()
+		{
+			std::unique_lock lock{ _lock };
+			return _strings.load_factor();
+		}
+	private:
+		static char* Allocate(std::size_t a_size);
+
+		static constexpr std::size_t BlockSize = 1 << 16;
+
+		static inline std::mutex _lock;
+		static inline std::vector<std::unique_ptr<char[]>> _blocks;
+		static inline std::size_t _used = BlockSize;
+		static inline std::size_t _bytes = 0;
+		static inline std::unordered_set<std::string_view> _strings;
+	};
+}
@@ -0,0 +1,115 @@
+#include "Trace.h"
+
+using namespace C3;
+
+std::string Trace::EncodeHeader()
+{
+	std::string out{ Magic };
+	out.push_back(static_cast<char>(Version));
+	return out;
+}
+
+std::string Trace::Encode(const Record& a_record)
+{
+	std::string out;
+	out.reserve(32 + a_record.line.size() + a_record.result.size());
+
+	PutVarint(out, a_record.time);
+	PutVarint(out, a_record.bind);
+	PutVarint(out, a_record.total);
+	PutVarint(out, a_record.ref);
+	out.push_back(static_cast<char>(a_record.status));
+	PutString(out, a_record.line);
+	PutString(out, a_record.cmd);
+	PutString(out, a_record.sub);
+	PutVarint(out, a_record.values.size());
+	for (const auto& value : a_record.values) {
+		PutString(out, value);
+	}
+	PutString(out, a_record.result);
+
+	return out;
+}
+
+std::vector<Trace::Record> Trace::Read(std::istream& a_stream)
+{
+	const std::string data{ std::istreambuf_iterator<char>{ a_stream }, std::istreambuf_iterator<char>{} };
+	std::string_view in{ data };
+
+	if (!in.starts_with(Magic) || in.size() <= Magic.size())
+		throw std::runtime_error("not a trace file");
+	in.remove_prefix(Magic.size());
+
+	if (static_cast<std::uint8_t>(in.front()) != Version)
+		throw std::runtime_error(std::format("unsupported trace version {}", static_cast<int>(in.front())));
+	in.remove_prefix(1);
+
+	std::vector<Record> records;
+	while (!in.empty()) {
+		auto& record = records.emplace_back();
+		record.time = GetVarint(in);
+		record.bind = GetVarint(in);
+		record.total = GetVarint(in);
+		record.ref = static_cast<std::uint32_t>(GetVarint(in));
+
+		if (in.empty())
+			throw std::runtime_error("truncated record");
+		record.status = static_cast<Status>(in.front());
+		in.remove_prefix(1);
+
+		record.line = GetString(in);
+		record.cmd = GetString(in);
+		record.sub = GetString(in);
+		record.values.resize(GetVarint(in));
+		for (auto& value : record.values) {
+			value = GetString(in);
+		}
+		record.result = GetString(in);
+	}
+
+	return records;
+}
+
+void Trace::PutVarint(std::string& a_out, std::uint64_t a_value)
+{
+	while (a_value >= 0x80) {
+		a_out.push_back(static_cast<char>((a_value & 0x7F) | 0x80));
+		a_value >>= 7;
+	}
+	a_out.push_back(static_cast<char>(a_value));
+}
+
+void Trace::PutString(std::string& a_out, std::string_view a_str)
+{
+	PutVarint(a_out, a_str.size());
+	a_out += a_str;
+}
+
+std::uint64_t Trace::GetVarint(std::string_view& a_in)
+{
+	std::uint64_t value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (a_in.empty())
+			throw std::runtime_error("truncated record");
+
+		const auto byte = static_cast<std::uint8_t>(a_in.front());
+		a_in.remove_prefix(1);
+
+		value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+		if (!(byte & 0x80))
+			return value;
+	}
+
+	throw std::runtime_error("malformed varint");
+}
+
+std::string Trace::GetString(std::string_view& a_in)
+{
+	const auto size = GetVarint(a_in);
+	if (size > a_in.size())
+		throw std::runtime_error("truncated record");
+
+	std::string str{ a_in.substr(0, size) };
+	a_in.remove_prefix(size);
+	return str;
+}
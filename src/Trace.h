@@ -0,0 +1,46 @@
+#pragma once
+
+namespace C3
+{
+	// compact binary trace of console commands, shared by the in-game recorder and the offline replayer
+	// integers are LEB128 varints and strings are length-prefixed, so a typical record is a few dozen bytes
+	class Trace
+	{
+	public:
+		static constexpr std::string_view Magic = "C3TR";
+		static constexpr std::uint8_t Version = 1;
+
+		enum class Status : std::uint8_t
+		{
+			Ok,
+			Cached,
+			Help,
+			Error,
+		};
+
+		struct Record
+		{
+			std::uint64_t time = 0;  // ns since recording started
+			std::uint64_t bind = 0;  // ns spent tokenizing and binding
+			std::uint64_t total = 0;  // ns from the console to the result
+			std::uint32_t ref = 0;
+			Status status = Status::Ok;
+			std::string line;
+			std::string cmd;
+			std::string sub;
+			std::vector<std::string> values;
+			std::string result;
+		};
+
+		static std::string EncodeHeader();
+		static std::string Encode(const Record& a_record);
+
+		// reads every record in a trace, throws if the header or a record is malformed
+		static std::vector<Record> Read(std::istream& a_stream);
+	private:
+		static void PutVarint(std::string& a_out, std::uint64_t a_value);
+		static void PutString(std::string& a_out, std::string_view a_str);
+		static std::uint64_t GetVarint(std::string_view& a_in);
+		static std::string GetString(std::string_view& a_in);
+	};
+}
@@ -1,38 +1,15 @@
-#pragma
+#pragma once
 
 #include "Command.h"
+#include "Dispatcher.h"
+#include "FormIndex.h"
+#include "Parser.h"
 #include "Script.h"
 
 namespace C3::Util
 {
 	using _GetFormEditorID = const char* (*)(std::uint32_t);
 	
-	inline std::string GetDefault(const Arg& a_arg)
-	{
-		if (!a_arg.defaultVal.empty())
-			return a_arg.defaultVal;
-
-		switch (a_arg.type) {
-		case Arg::Type::Int:
-			return "0";
-		case Arg::Type::Bool:
-			return "false";
-		case Arg::Type::Float:
-			return "0.0";
-		case Arg::Type::String:
-			return "";
-		case Arg::Type::Object:
-		default: 
-			return "none";
-		}
-	}
-
-	inline bool IsNumeric(std::string a_str)
-	{
-		static const std::regex pattern(R"(^[+-]?(?:\d+|\d*\.\d+)$)");
-		return std::regex_match(a_str, pattern);
-	}
-
 	inline std::string Lowercase(const char* a_str)
 	{
 		std::string data{ a_str };
@@ -53,23 +30,40 @@ namespace C3::Util
 		return data;
 	}
 
-	inline std::string GetEditorID(RE::TESForm* a_form)
+	// po3_Tweaks keeps the editor IDs most form types drop at load, only the form id is passed so no form is touched
+	inline std::string GetTweaksEditorID(RE::FormID a_formID)
 	{
 		static auto tweaks = GetModuleHandle(L"po3_Tweaks");
 		static auto func = reinterpret_cast<_GetFormEditorID>(GetProcAddress(tweaks, "GetFormEditorID"));
 		if (func) {
-			return func(a_form->formID);
+			if (const auto editorID = func(a_formID))
+				return editorID;
 		}
 		return {};
 	}
 
+	inline std::string GetEditorID(RE::TESForm* a_form)
+	{
+		if (const auto editorID = FormIndex::GetEditorID(a_form->formID); !editorID.empty()) {
+			return std::string{ editorID };
+		}
+
+		return GetTweaksEditorID(a_form->formID);
+	}
+
 	inline bool IsEditorID(const std::string_view identifier) { return std::strchr(identifier.data(), '|') == nullptr; }
 	
 	inline std::pair<RE::FormID, std::string> GetFormIDAndPluginName(const std::string_view a_str)
 	{
 		if (const auto tilde{ std::strchr(a_str.data(), '|') }) {
 			const auto tilde_pos{ static_cast<int>(tilde - a_str.data()) };
-			return { std::stoi(std::string{ a_str.substr(0, tilde_pos) }, 0, 16), a_str.substr(tilde_pos + 1).data() };
+			auto first = a_str.data();
+			if (tilde_pos > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X'))
+				first += 2;
+
+			RE::FormID formID = 0;
+			std::from_chars(first, a_str.data() + tilde_pos, formID, 16);
+			return { formID, a_str.substr(tilde_pos + 1).data() };
 		}
 
 		return { 0, "" };
@@ -80,16 +74,105 @@ namespace C3::Util
 		return b ? "true" : "false";
 	}
 
+	// values are validated at bind with the same parser, a malformed one still never throws on the worker and falls back to 0
+	template <class T>
+	inline T StringToNumber(std::string_view a_str)
+	{
+		if (const auto value = Parser::ToNumber<T>(a_str))
+			return *value;
+
+		logger::warn("'{}' is not a number - using 0", a_str);
+		return T{};
+	}
+
 	inline RE::TESForm* StringToForm(std::string_view a_str)
 	{
 		if (const auto form = RE::TESForm::LookupByEditorID(a_str)) {
 			return form;
 		}
 
+		if (IsEditorID(a_str)) {
+			return FormIndex::Find(a_str);
+		}
+
 		const auto& [formId, modName] = GetFormIDAndPluginName(a_str);
 		return RE::TESDataHandler::GetSingleton()->LookupForm(formId, modName);
 	}
 
+	// comma separated identifiers, where editor ID globs (Bandit*) expand through the form index
+	inline std::vector<RE::TESForm*> StringToForms(std::string_view a_str, std::size_t a_max = FormIndex::MaxMatches)
+	{
+		std::vector<RE::TESForm*> forms;
+
+		for (const auto part : std::views::split(a_str, ',')) {
+			const std::string identifier{ part.begin(), part.end() };
+			if (identifier.empty() || forms.size() >= a_max)
+				continue;
+
+			if (FormIndex::IsPattern(identifier)) {
+				auto matches = FormIndex::Match(identifier, a_max - forms.size());
+				forms.insert(forms.end(), matches.begin(), matches.end());
+			} else if (const auto form = StringToForm(identifier)) {
+				forms.push_back(form);
+			} else {
+				logger::warn("could not find form {}", identifier);
+			}
+		}
+
+		return forms;
+	}
+
+	// resolves the forms an object argument refers to, safe to call off the main thread
+	// selected refs are left empty and filled in from the target at dispatch
+	inline std::vector<RE::TESForm*> ResolveForms(const Arg& a_arg, const std::string& a_val)
+	{
+		if (a_arg.type != Arg::Type::Object || a_val == "none" || a_arg.selected)
+			return {};
+
+		if (a_arg.array)
+			return StringToForms(a_val);
+
+		if (a_arg.rawType == "actor" && a_val == "player")
+			return { RE::PlayerCharacter::GetSingleton() };
+
+		if (const auto form = StringToForm(a_val))
+			return { form };
+
+		return {};
+	}
+
+	// a_type is a record signature such as NPC_ or WEAP
+	inline bool IsFormType(const RE::TESForm* a_form, std::string_view a_type)
+	{
+		const auto type = RE::FormTypeToString(a_form->GetFormType());
+		return type.size() == a_type.size() && _strnicmp(type.data(), a_type.data(), a_type.size()) == 0;
+	}
+
+	inline std::string VariableToString(const RE::BSScript::Variable& a_var)
+	{
+		using RawType = RE::BSScript::TypeInfo::RawType;
+
+		switch (a_var.GetType().GetRawType()) {
+		case RawType::kNone:
+			return "none";
+		case RawType::kObject:
+			// TODO: implement
+			// maybe try to get the object, and then invoke GetFormID() on it?
+			return "completed";
+		case RawType::kString:
+			return std::string{ a_var.GetString() };
+		case RawType::kInt:
+			return std::to_string(a_var.GetSInt());
+		case RawType::kFloat:
+			return std::to_string(a_var.GetFloat());
+		case RawType::kBool:
+			return BoolToString(a_var.GetBool());
+		default:
+			// TODO: handle arrays
+			return "completed";
+		}
+	}
+
 	class VmCallback : public RE::BSScript::IStackCallbackFunctor
 	{
 	public:
@@ -122,22 +205,20 @@ namespace C3::Util
 	{
 	private:
 		RE::BSScrapArray<RE::BSScript::Variable> _variables;
-
-		std::vector<Script::TypePtr> _typeOverrides;
-		std::vector<Script::ObjectPtr> _overriden;
 	public:
 		FunctionArguments() noexcept = default;
 		FunctionArguments(std::size_t capacity)
 		{
 			_variables.reserve((RE::BSTArrayBase::size_type) capacity);
 		}
-		FunctionArguments(const std::vector<Arg>& args, const std::vector<std::string>& values, RE::TESObjectREFR* a_target)
+		// the dispatch target holds the resolved script type and class name of each object argument
+		FunctionArguments(const std::vector<Arg>& args, const std::vector<std::string>& values, const std::vector<std::vector<RE::TESForm*>>& forms, const Dispatcher::Target& a_dispatch, RE::TESObjectREFR* a_target)
 		{
 			assert(args.size() == values.size());
+			assert(args.size() == forms.size());
+			assert(args.size() == a_dispatch.types.size());
 
 			_variables.reserve((RE::BSTArrayBase::size_type) values.size());
-			_typeOverrides.reserve(values.size());
-			_overriden.reserve(values.size());
 
 			for (RE::BSTArrayBase::size_type i = 0; i < args.size(); i++) {
 				const auto& arg = args[i];
@@ -151,23 +232,20 @@ namespace C3::Util
 				if (val == "none") {
 					scriptVariable.emplace();
 					scriptVariable->SetNone();
+				} else if (arg.array) {
+					scriptVariable = MakeArray(arg, val, forms[i], a_dispatch.types[i], a_dispatch.classes[i]);
 				} else {
 					switch (arg.type) {
 					case Arg::Type::Object:
 						{
 							const auto& objType = arg.rawType;
-							const auto& normalised = Lowercase(objType);
 
 							RE::TESForm* form = nullptr;
 
 							if (arg.selected) {
 								form = a_target;
-							} else {
-								if (objType == "actor" && val == "player") {
-									form = RE::PlayerCharacter::GetSingleton();
-								} else {
-									form = StringToForm(val);
-								}
+							} else if (!forms[i].empty()) {
+								form = forms[i].front();
 							}
 
 							logger::info("Found form {} - {}", form != nullptr, objType);
@@ -179,14 +257,9 @@ namespace C3::Util
 							}
 							logger::info("Form is {} {}", form->GetFormID(), GetEditorID(form));
 
-							auto object = Script::GetObjectPtr(form, objType.c_str());
+							auto object = Script::GetBoundObject(form, a_dispatch.classes[i]);
 
 							logger::info("Found {} ptr {}", objType, object != nullptr);
-							
-							if (!object) {
-								object = Script::GetObjectPtr(form, "form");
-								logger::info("Found {} ptr {}", objType, object != nullptr);
-							}
 
 
 							if (!object) {
@@ -195,30 +268,16 @@ namespace C3::Util
 								break;
 							}
 
-							// why god why?
-							if (object) {
-								auto newType = object->type;
-								auto type = object->GetTypeInfo();
-
-								while (type && Lowercase(type->GetName()) != normalised) {
-									type = type->GetParent();
-								}
-
-								if (type && type != object->type.get() && Lowercase(type->GetName()) == normalised) {
-
-									_typeOverrides.emplace_back(object->type);
-									_overriden.push_back(object);
-
-									RE::BSTSmartPointer ptr{ type };
+							// the variable carries the declared parent type, the shared object itself is never retyped
+							scriptVariable.emplace();
 
-									object->type = ptr;
-									logger::info("swapping type to {}", object->type->GetName());
-								}
+							const auto& type = a_dispatch.types[i];
+							if (type && Script::Inherits(object->GetTypeInfo(), type.get())) {
+								scriptVariable->SetObject(std::move(object), Script::GetRawType(type.get()));
+							} else {
+								scriptVariable->SetObject(std::move(object));
 							}
 
-							scriptVariable.emplace();
-							scriptVariable->SetObject(std::move(object));
-
 							break;
 						}
 					case Arg::Type::String:
@@ -231,14 +290,14 @@ namespace C3::Util
 					case Arg::Type::Int:
 						{
 							scriptVariable.emplace();
-							scriptVariable->SetSInt(std::stoi(val));
+							scriptVariable->SetSInt(StringToNumber<std::int32_t>(val));
 
 							break;
 						}
 					case Arg::Type::Float:
 						{
 							scriptVariable.emplace();
-							scriptVariable->SetFloat(std::stof(val));
+							scriptVariable->SetFloat(StringToNumber<float>(val));
 
 							break;
 						}
@@ -270,22 +329,97 @@ namespace C3::Util
 			return true;
 		}
 
-		void ClearOverrides() {
-			for (auto i = 0; i < _overriden.size(); i++) {
-				_overriden[i]->type = _typeOverrides[i];
-				_overriden[i].reset();
-				_typeOverrides[i].reset();
+		static RE::BSScript::Variable MakeArray(const Arg& a_arg, const std::string& a_val, const std::vector<RE::TESForm*>& a_forms, const Script::TypePtr& a_type, const RE::BSFixedString& a_class)
+		{
+			using RawType = RE::BSScript::TypeInfo::RawType;
+
+			RE::BSScript::Variable var;
+			var.SetNone();
+
+			auto vm = Script::InternalVM::GetSingleton();
+			if (!vm)
+				return var;
+
+			Script::ArrayPtr array;
+
+			if (a_arg.type == Arg::Type::Object) {
+				const auto& forms = a_forms;
+
+				if (!a_type) {
+					logger::error("unknown script type {}", a_arg.rawType);
+					return var;
+				}
+
+				const auto elementType = Script::GetRawType(a_type.get());
+				if (!vm->CreateArray(RE::BSScript::TypeInfo{ elementType }, static_cast<std::uint32_t>(forms.size()), array) || !array)
+					return var;
+
+				for (std::uint32_t i = 0; i < forms.size(); i++) {
+					auto object = Script::GetBoundObject(forms[i], a_class);
+
+					if (object && Script::Inherits(object->GetTypeInfo(), a_type.get()))
+						(*array)[i].SetObject(std::move(object), elementType);
+					else if (object)
+						(*array)[i].SetObject(std::move(object));
+					else
+						(*array)[i].SetNone();
+				}
+
+				logger::info("expanded {} to {} {} forms", a_val, forms.size(), a_arg.rawType);
+			} else {
+				std::vector<std::string> parts;
+				for (const auto part : std::views::split(std::string_view{ a_val }, ',')) {
+					parts.emplace_back(part.begin(), part.end());
+				}
+
+				RawType elementType = RawType::kString;
+				switch (a_arg.type) {
+				case Arg::Type::Int:
+					elementType = RawType::kInt;
+					break;
+				case Arg::Type::Float:
+					elementType = RawType::kFloat;
+					break;
+				case Arg::Type::Bool:
+					elementType = RawType::kBool;
+					break;
+				default:
+					break;
+				}
+
+				if (!vm->CreateArray(RE::BSScript::TypeInfo{ elementType }, static_cast<std::uint32_t>(parts.size()), array) || !array)
+					return var;
+
+				for (std::uint32_t i = 0; i < parts.size(); i++) {
+					const auto& part = parts[i];
+					switch (a_arg.type) {
+					case Arg::Type::Int:
+						(*array)[i].SetSInt(StringToNumber<std::int32_t>(part));
+						break;
+					case Arg::Type::Float:
+						(*array)[i].SetFloat(StringToNumber<float>(part));
+						break;
+					case Arg::Type::Bool:
+						(*array)[i].SetBool(part == "1" || part == "true" || part == "TRUE");
+						break;
+					default:
+						(*array)[i].SetString(part);
+						break;
+					}
+				}
 			}
+
+			var.SetArray(std::move(array));
+			return var;
 		}
 	};
 
-	inline bool InvokeFuncWithArgs(std::string a_scr, std::string a_func, std::vector<Arg>& a_args, std::vector<std::string>& a_vals, RE::TESObjectREFR* a_target, std::function<void(const RE::BSScript::Variable& a_var)> a_onResult)
+	// script, function and class names arrive pre-interned from the dispatch target, so nothing is converted per call
+	inline bool InvokeFuncWithArgs(const Dispatcher::Target& a_dispatch, const std::vector<Arg>& a_args, const std::vector<std::string>& a_vals, const std::vector<std::vector<RE::TESForm*>>& a_forms, RE::TESObjectREFR* a_target, std::function<void(const RE::BSScript::Variable& a_var)> a_onResult)
 	{
-		logger::info("invoking {} in {} with {} arguments", a_func, a_scr, a_vals.size());
+		logger::info("invoking {} in {} with {} arguments", a_dispatch.func.c_str(), a_dispatch.script.c_str(), a_vals.size());
 
-
-		//std::vector<std::string> forced{ "player", "none" };
-		auto args = new FunctionArguments(a_args, a_vals, a_target);
+		auto args = new FunctionArguments(a_args, a_vals, a_forms, a_dispatch, a_target);
 
 		RE::BSTSmartPointer<RE::BSScript::IStackCallbackFunctor> callback;
 		callback.reset(new VmCallback(a_onResult));
@@ -293,12 +427,9 @@ namespace C3::Util
 
 		bool result = false;
 		if (auto vm = RE::BSScript::Internal::VirtualMachine::GetSingleton()) {
-			result = vm->DispatchStaticCall(a_scr, a_func, args, callback);
+			result = vm->DispatchStaticCall(a_dispatch.script, a_dispatch.func, args, callback);
 		}
 
-		// this is genuinely the worst fucking thing i have ever done 
-		args->ClearOverrides();
-
 		return result;
 	}
 }
\ No newline at end of file
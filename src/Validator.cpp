@@ -0,0 +1,115 @@
+#include "Validator.h"
+#include "Parser.h"
+#include "StringPool.h"
+
+using namespace C3;
+
+const Validator* Validator::Compile(const Spec& a_spec, bool a_numeric)
+{
+	Validator validator;
+	validator._numeric = a_numeric;
+	validator._min = a_spec.min;
+	validator._max = a_spec.max;
+
+	bool constrained = a_spec.min || a_spec.max;
+
+	if (!a_spec.choices.empty()) {
+		std::vector<std::string_view> interned;
+		for (const auto& choice : a_spec.choices) {
+			interned.push_back(StringPool::Intern(choice));
+			if (!validator._choiceList.empty())
+				validator._choiceList += ", ";
+			validator._choiceList += interned.back();
+		}
+
+		validator._choices.Build(interned);
+		constrained = true;
+	}
+
+	if (a_spec.pattern) {
+		validator._patternSource = StringPool::Intern(*a_spec.pattern);
+		validator._pattern.emplace(std::string{ validator._patternSource }, std::regex::ECMAScript | std::regex::optimize);
+		constrained = true;
+	}
+
+	if (a_spec.formType) {
+		validator._formType = StringPool::Intern(*a_spec.formType);
+		constrained = true;
+	}
+
+	if (!constrained)
+		return nullptr;
+
+	std::unique_lock lock{ _lock };
+	return &_validators.emplace_back(std::move(validator));
+}
+
+std::optional<std::string> Validator::Check(std::string_view a_value) const
+{
+	if (_numeric && (_min || _max)) {
+		const auto value = Parser::ToNumber<double>(a_value).value_or(0.0);
+
+		if (_min && value < *_min)
+			return std::format("{} is below the minimum of {}", a_value, *_min);
+		if (_max && value > *_max)
+			return std::format("{} is above the maximum of {}", a_value, *_max);
+	}
+
+	if (!_choices.IsEmpty() && !_choices.Contains(a_value))
+		return std::format("'{}' is not one of {}", a_value, _choiceList);
+
+	if (_pattern && !std::regex_match(a_value.begin(), a_value.end(), *_pattern))
+		return std::format("'{}' does not match {}", a_value, _patternSource);
+
+	return std::nullopt;
+}
+
+void Validator::ChoiceSet::Build(const std::vector<std::string_view>& a_choices)
+{
+	if (a_choices.empty())
+		return;
+
+	auto size = std::bit_ceil(a_choices.size() * 2);
+
+	while (true) {
+		for (std::uint64_t seed = 1; seed <= 64; seed++) {
+			std::vector<std::string_view> slots(size);
+			bool collision = false;
+
+			for (const auto choice : a_choices) {
+				auto& slot = slots[Hash(choice, seed) & (size - 1)];
+				if (slot.data() && slot != choice) {
+					collision = true;
+					break;
+				}
+				slot = choice;
+			}
+
+			if (!collision) {
+				_slots = std::move(slots);
+				_seed = seed;
+				_mask = size - 1;
+				return;
+			}
+		}
+
+		size *= 2;
+	}
+}
+
+bool Validator::ChoiceSet::Contains(std::string_view a_str) const
+{
+	const auto& slot = _slots[Hash(a_str, _seed) & _mask];
+	return slot.data() && slot == a_str;
+}
+
+std::uint64_t Validator::ChoiceSet::Hash(std::string_view a_str, std::uint64_t a_seed)
+{
+	// FNV-1a mixed with the seed
+	std::uint64_t hash = 14695981039346656037ull ^ (a_seed * 0x9E3779B97F4A7C15ull);
+	for (const auto c : a_str) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= 1099511628211ull;
+	}
+	return hash ^ (hash >> 29);
+}
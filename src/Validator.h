@@ -0,0 +1,52 @@
+#pragma once
+
+namespace C3
+{
+	// argument constraints compiled once at decode time and checked at bind time
+	class Validator
+	{
+	public:
+		// constraint keys as read from a definition, independent of the file format
+		struct Spec
+		{
+			std::optional<double> min;
+			std::optional<double> max;
+			std::vector<std::string> choices;
+			std::optional<std::string> pattern;
+			std::optional<std::string> formType;
+		};
+
+		// nullptr when the spec declares no constraints
+		static const Validator* Compile(const Spec& a_spec, bool a_numeric);
+
+		std::optional<std::string> Check(std::string_view a_value) const;
+		inline std::string_view GetFormType() const { return _formType; }
+	private:
+		// open-addressed table with a seed chosen so every choice lands in its own slot
+		class ChoiceSet
+		{
+		public:
+			void Build(const std::vector<std::string_view>& a_choices);
+			bool Contains(std::string_view a_str) const;
+			inline bool IsEmpty() const { return _slots.empty(); }
+		private:
+			static std::uint64_t Hash(std::string_view a_str, std::uint64_t a_seed);
+
+			std::vector<std::string_view> _slots;
+			std::uint64_t _seed = 0;
+			std::uint64_t _mask = 0;
+		};
+
+		bool _numeric = false;
+		std::optional<double> _min;
+		std::optional<double> _max;
+		ChoiceSet _choices;
+		std::string _choiceList;
+		std::optional<std::regex> _pattern;
+		std::string_view _patternSource;
+		std::string_view _formType;
+
+		static inline std::mutex _lock;
+		static inline std::deque<Validator> _validators;
+	};
+}
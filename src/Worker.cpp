@@ -0,0 +1,35 @@
+#include "Worker.h"
+
+using namespace C3;
+
+void Worker::Enqueue(std::function<void()> a_job)
+{
+	std::call_once(_started, [] { std::thread(Run).detach(); });
+
+	{
+		std::unique_lock lock{ _lock };
+		_jobs.push_back(std::move(a_job));
+	}
+	_cv.notify_one();
+}
+
+void Worker::Run()
+{
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock lock{ _lock };
+			_cv.wait(lock, [] { return !_jobs.empty(); });
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		try {
+			job();
+		} catch (std::exception& e) {
+			logger::error("worker job failed due to {}", e.what());
+		} catch (...) {
+			logger::error("worker job failed");
+		}
+	}
+}
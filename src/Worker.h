@@ -0,0 +1,18 @@
+#pragma once
+
+namespace C3
+{
+	// single background thread running jobs in submission order
+	class Worker
+	{
+	public:
+		static void Enqueue(std::function<void()> a_job);
+	private:
+		static void Run();
+
+		static inline std::once_flag _started;
+		static inline std::mutex _lock;
+		static inline std::condition_variable _cv;
+		static inline std::deque<std::function<void()>> _jobs;
+	};
+}
@@ -0,0 +1,88 @@
+#include "Writer.h"
+
+using namespace C3;
+
+void Writer::Write(std::string_view a_file, std::string a_text, bool a_append)
+{
+	std::call_once(_started, [] { std::thread(Run).detach(); });
+
+	auto node = new Node{ nullptr, std::string{ a_file }, std::move(a_text), a_append };
+	node->next = _head.load(std::memory_order_relaxed);
+	while (!_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {}
+
+	_head.notify_one();
+}
+
+void Writer::Flush()
+{
+	// called at shutdown, skip rather than hang if the writer thread died mid-write
+	std::unique_lock lock{ _io, std::defer_lock };
+	if (!lock.try_lock_for(std::chrono::milliseconds(250)))
+		return;
+
+	Drain();
+}
+
+std::filesystem::path Writer::GetDirectory()
+{
+	auto path = logger::log_directory().value_or(std::filesystem::path{});
+	path /= Plugin::NAME;
+	return path;
+}
+
+void Writer::Run()
+{
+	while (true) {
+		_head.wait(nullptr, std::memory_order_acquire);
+
+		std::unique_lock lock{ _io };
+		Drain();
+	}
+}
+
+void Writer::Drain()
+{
+	auto node = _head.exchange(nullptr, std::memory_order_acquire);
+	if (!node)
+		return;
+
+	// the stack pops newest first, reverse it to keep output in submission order
+	Node* ordered = nullptr;
+	while (node) {
+		auto next = node->next;
+		node->next = ordered;
+		ordered = node;
+		node = next;
+	}
+
+	// the batch is written while producers keep filling the now empty stack
+	std::unordered_set<std::ofstream*> touched;
+	while (ordered) {
+		std::unique_ptr<Node> current{ ordered };
+		ordered = current->next;
+
+		auto& file = _files[current->file];
+		if (!current->append || !file.is_open()) {
+			if (file.is_open())
+				file.close();
+
+			const auto dir = GetDirectory();
+			std::error_code ec;
+			std::filesystem::create_directories(dir, ec);
+
+			const auto mode = current->append ? std::ios::out | std::ios::app : std::ios::out | std::ios::trunc;
+			file.open(dir / current->file, mode | std::ios::binary);
+			if (!file.is_open()) {
+				logger::error("failed to open {} for writing", current->file);
+				continue;
+			}
+		}
+
+		file << current->text;
+		touched.insert(&file);
+	}
+
+	for (const auto file : touched) {
+		file->flush();
+	}
+}
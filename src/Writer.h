@@ -0,0 +1,32 @@
+#pragma once
+
+namespace C3
+{
+	// background file writer for redirected command output and traces, text is written as given
+	// producers push onto a lock-free stack and never touch the disk, the writer thread drains it in batches
+	class Writer
+	{
+	public:
+		static void Write(std::string_view a_file, std::string a_text, bool a_append);
+		static void Flush();
+		static std::filesystem::path GetDirectory();
+	private:
+		struct Node
+		{
+			Node* next;
+			std::string file;
+			std::string text;
+			bool append;
+		};
+
+		static void Run();
+		static void Drain();
+
+		static inline std::once_flag _started;
+		static inline std::atomic<Node*> _head = nullptr;
+
+		// only taken by the consumers, the writer thread and Flush
+		static inline std::timed_mutex _io;
+		static inline std::unordered_map<std::string, std::ofstream> _files;
+	};
+}
@@ -1,5 +1,9 @@
 #include "Hooks.h"
+#include "Cache.h"
 #include "Commands.h"
+#include "FormIndex.h"
+#include "Papyrus.h"
+#include "Writer.h"
 
 using namespace C3;
 
@@ -27,6 +31,22 @@ void InitializeLog([[maybe_unused]] spdlog::level::level_enum a_level = spdlog::
 	spdlog::set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%l] [%t] [%s:%#] %v");
 }
 
+void MessageHandler(SKSE::MessagingInterface::Message* a_msg)
+{
+	switch (a_msg->type) {
+	case SKSE::MessagingInterface::kDataLoaded:
+		FormIndex::Build();
+		Commands::Resolve();
+		break;
+	case SKSE::MessagingInterface::kPreLoadGame:
+	case SKSE::MessagingInterface::kNewGame:
+		Cache::Clear();
+		break;
+	default:
+		break;
+	}
+}
+
 extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Load(const SKSE::LoadInterface* a_skse)
 {
 	InitializeLog();
@@ -36,6 +56,10 @@ extern "C" DLLEXPORT bool SKSEAPI SKSEPlugin_Load(const SKSE::LoadInterface* a_s
 	Hooks::Install();
 	Commands::Load();
 
+	SKSE::GetMessagingInterface()->RegisterListener(MessageHandler);
+	SKSE::GetPapyrusInterface()->Register(Papyrus::Register);
+	std::atexit(Writer::Flush);
+
 	return true;
 }
 
@@ -0,0 +1,64 @@
+#pragma once
+
+// stands in for the plugin PCH, providing only what the portable core uses
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <regex>
+#include <shared_mutex>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std::literals;
+
+#include <nlohmann/json.hpp>
+using json = nlohmann::json;
+
+#include "yaml-cpp/yaml.h"
+
+#include <magic_enum.hpp>
+
+// binding logs every token at info, which would swamp the timings, so only warnings and errors print by default
+namespace logger
+{
+	inline bool verbose = false;
+
+	template <class... Args>
+	void info(std::format_string<Args...> a_fmt, Args&&... a_args)
+	{
+		if (verbose)
+			std::clog << std::format(a_fmt, std::forward<Args>(a_args)...) << '\n';
+	}
+
+	template <class... Args>
+	void warn(std::format_string<Args...> a_fmt, Args&&... a_args)
+	{
+		std::clog << "warning: " << std::format(a_fmt, std::forward<Args>(a_args)...) << '\n';
+	}
+
+	template <class... Args>
+	void error(std::format_string<Args...> a_fmt, Args&&... a_args)
+	{
+		std::clog << "error: " << std::format(a_fmt, std::forward<Args>(a_args)...) << '\n';
+	}
+}
@@ -0,0 +1,228 @@
+#include "Decoder.h"
+#include "Parser.h"
+#include "Trace.h"
+
+using namespace C3;
+namespace fs = std::filesystem;
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+	// stands in for the papyrus VM: checks the call is well formed and answers with the recorded result
+	class StandInVM
+	{
+	public:
+		std::optional<std::string> Invoke(const Command& a_cmd, const SubCommand& a_sub, const std::vector<std::string>& a_values, const Trace::Record& a_record)
+		{
+			if (a_cmd.script.empty() || a_sub.func.empty())
+				return std::nullopt;
+
+			if (a_values.size() != a_sub.args.size())
+				return std::nullopt;
+
+			_calls++;
+			return a_record.result;
+		}
+
+		inline std::size_t GetCalls() const { return _calls; }
+	private:
+		std::size_t _calls = 0;
+	};
+
+	struct Registry
+	{
+		void Load(const fs::path& a_dir)
+		{
+			std::vector<fs::path> paths;
+			for (const auto& entry : fs::directory_iterator(a_dir)) {
+				const auto extension = entry.path().extension();
+				if (entry.is_regular_file() && (extension == ".yaml" || extension == ".yml" || extension == ".json"))
+					paths.push_back(entry.path());
+			}
+
+			// the game iterates in directory order too, but sorting keeps collisions reproducible across machines
+			std::ranges::sort(paths);
+
+			for (const auto& path : paths) {
+				try {
+					auto result = Decoder::DecodeFile(path);
+					for (const auto& error : result.errors) {
+						logger::error("{}: {}", path.string(), error);
+					}
+
+					for (auto& command : result.commands) {
+						if (lookup.contains(command.name)) {
+							logger::error("{} already registered as a command - skipping", command.name);
+							continue;
+						}
+
+						const auto& stored = commands.emplace_back(std::move(command));
+						lookup[stored.name] = &stored;
+						if (!stored.alias.empty() && !lookup.contains(stored.alias))
+							lookup[stored.alias] = &stored;
+					}
+				} catch (std::exception& e) {
+					logger::error("failed to create command from file: {} due to {}", path.string(), e.what());
+				}
+			}
+		}
+
+		const Command* Find(std::string_view a_name) const
+		{
+			const auto it = lookup.find(a_name);
+			return it != lookup.end() ? it->second : nullptr;
+		}
+
+		std::deque<Command> commands;
+		std::unordered_map<std::string_view, const Command*> lookup;
+	};
+
+	struct Stats
+	{
+		std::vector<std::uint64_t> bind;
+		std::vector<std::uint64_t> recordedBind;
+		std::vector<std::uint64_t> recordedTotal;
+		std::size_t replayed = 0;
+		std::size_t mismatches = 0;
+	};
+
+	std::uint64_t Percentile(std::vector<std::uint64_t> a_samples, double a_rank)
+	{
+		if (a_samples.empty())
+			return 0;
+
+		const auto index = static_cast<std::size_t>(a_rank * static_cast<double>(a_samples.size() - 1));
+		std::ranges::nth_element(a_samples, a_samples.begin() + index);
+		return a_samples[index];
+	}
+
+	std::string Summary(const std::vector<std::uint64_t>& a_samples)
+	{
+		return std::format("p50 {:.2f}us p99 {:.2f}us", Percentile(a_samples, 0.5) / 1000.0, Percentile(a_samples, 0.99) / 1000.0);
+	}
+
+	std::string Join(const std::vector<std::string>& a_strs, std::string_view a_separator)
+	{
+		std::string joined;
+		for (std::size_t i = 0; i < a_strs.size(); i++) {
+			if (i > 0)
+				joined += a_separator;
+			joined += a_strs[i];
+		}
+		return joined;
+	}
+
+	// an empty result means the record replayed as it was recorded
+	std::string Replay(const Registry& a_registry, StandInVM& a_vm, const Trace::Record& a_record, Stats& a_stats)
+	{
+		auto tokens = Parser::Tokenize(a_record.line);
+		Parser::ExtractRedirect(tokens, a_record.line);
+
+		if (tokens.empty())
+			return "line no longer tokenizes";
+
+		const auto cmd = a_registry.Find(tokens[0]);
+		if (!cmd) {
+			if (a_record.status == Trace::Status::Error && a_record.cmd.empty())
+				return {};
+			return std::format("unknown command {}", tokens[0]);
+		}
+
+		const auto start = Clock::now();
+		const auto invocation = Parser::Bind(*cmd, tokens, a_record.ref != 0, false);
+		a_stats.bind.push_back(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+
+		if (invocation.help)
+			return a_record.status == Trace::Status::Help ? std::string{} : "bound as help";
+
+		if (!invocation.IsValid()) {
+			const auto errors = Join(invocation.errors, "\n");
+			if (a_record.status != Trace::Status::Error)
+				return std::format("failed to bind: {}", errors);
+			return errors == a_record.result ? std::string{} : std::format("errors changed: {}", errors);
+		}
+
+		if (invocation.sub->name != a_record.sub)
+			return std::format("bound to {} instead of {}", invocation.sub->name, a_record.sub);
+
+		if (invocation.values != a_record.values)
+			return std::format("values changed: [{}] instead of [{}]", Join(invocation.values, " "), Join(a_record.values, " "));
+
+		// errors recorded after a successful bind came from form lookups, which the replayer cannot reproduce
+		if (a_record.status == Trace::Status::Error)
+			return {};
+
+		if (!a_vm.Invoke(*cmd, *invocation.sub, invocation.values, a_record))
+			return "rejected by the stand-in vm";
+
+		return {};
+	}
+}
+
+int main(int a_argc, char** a_argv)
+{
+	std::vector<std::string_view> args{ a_argv + 1, a_argv + a_argc };
+
+	std::size_t repeat = 1;
+	std::vector<std::string_view> positional;
+	for (std::size_t i = 0; i < args.size(); i++) {
+		if (args[i] == "-v") {
+			logger::verbose = true;
+		} else if (args[i] == "-n" && i + 1 < args.size()) {
+			std::from_chars(args[i + 1].data(), args[i + 1].data() + args[i + 1].size(), repeat);
+			i++;
+		} else {
+			positional.push_back(args[i]);
+		}
+	}
+
+	if (positional.size() != 2) {
+		std::cerr << "usage: c3replay [-v] [-n repeat] <definitions dir> <trace file>\n";
+		return 2;
+	}
+
+	Registry registry;
+	registry.Load(fs::path{ positional[0] });
+
+	std::vector<Trace::Record> records;
+	try {
+		std::ifstream file{ fs::path{ positional[1] }, std::ios::binary };
+		records = Trace::Read(file);
+	} catch (std::exception& e) {
+		std::cerr << std::format("failed to read trace {}: {}\n", positional[1], e.what());
+		return 2;
+	}
+
+	StandInVM vm;
+	Stats stats;
+
+	for (const auto& record : records) {
+		stats.recordedBind.push_back(record.bind);
+		stats.recordedTotal.push_back(record.total);
+	}
+
+	const auto start = Clock::now();
+	for (std::size_t pass = 0; pass < repeat; pass++) {
+		for (const auto& record : records) {
+			const auto mismatch = Replay(registry, vm, record, stats);
+			stats.replayed++;
+
+			// only the first pass reports, later passes exist for stable timings
+			if (!mismatch.empty() && pass == 0) {
+				stats.mismatches++;
+				std::cout << std::format("mismatch at {:.3f}s: {}\n    {}\n", record.time / 1e9, record.line, mismatch);
+			}
+		}
+	}
+	const auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+	std::cout << std::format("loaded {} commands, replayed {} records x{} ({} vm calls)\n", registry.commands.size(), records.size(), repeat, vm.GetCalls());
+	std::cout << std::format("bind (replay):   {}\n", Summary(stats.bind));
+	std::cout << std::format("bind (recorded): {}\n", Summary(stats.recordedBind));
+	std::cout << std::format("end to end (recorded): {}\n", Summary(stats.recordedTotal));
+	std::cout << std::format("throughput: {:.0f} lines/s\n", elapsed > 0.0 ? stats.replayed / elapsed : 0.0);
+	std::cout << std::format("mismatches: {}\n", stats.mismatches);
+
+	return stats.mismatches == 0 ? 0 : 1;
+}